@@ -30,6 +30,10 @@ def init(hr):
     hr.add_files("thirdparty/uvvm/bitvis_vip_uart/src/*.vhd",                "bitvis_vip_uart")
     hr.add_files("thirdparty/uvvm/uvvm_vvc_framework/src_target_dependent/*.vhd", "bitvis_vip_uart")
 
+    # AXI-Lite VIP
+    hr.add_files("thirdparty/uvvm/bitvis_vip_axilite/src/*.vhd",                  "bitvis_vip_axilite")
+    hr.add_files("thirdparty/uvvm/uvvm_vvc_framework/src_target_dependent/*.vhd", "bitvis_vip_axilite")
+
     # Clock Generator VVC
     hr.add_files("thirdparty/uvvm/bitvis_vip_clock_generator/src/*.vhd",          "bitvis_vip_clock_generator")
     hr.add_files("thirdparty/uvvm/uvvm_vvc_framework/src_target_dependent/*.vhd", "bitvis_vip_clock_generator")
@@ -0,0 +1,223 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "mapped_file.hpp"
+
+// Source of data that is read lazily, in chunks, as the simulation
+// consumes it. Used for data that should not be held in a VVC queue
+// all at once.
+class DataSource {
+public:
+  virtual ~DataSource() = default;
+
+  // Read up to max_len bytes into buf. For packet based sources, reading
+  // stops at end of packet, and end_of_packet is set if the last byte
+  // read was the last byte of a packet.
+  // Returns the number of bytes read.
+  virtual size_t Read(uint8_t* buf, size_t max_len, bool& end_of_packet) = 0;
+
+  // True when there is no more data to read
+  virtual bool Done() const = 0;
+};
+
+// Data from a byte vector. Used for data that has to be queued up
+// behind another source. A packet source ends with end of packet, and
+// should not be appended to once reading has started.
+class BytesSource : public DataSource {
+  std::vector<uint8_t> bytes;
+  size_t pos = 0;
+  bool packet;
+
+public:
+  explicit BytesSource(bool packet = false)
+    : packet(packet)
+  {
+  }
+
+  bool IsPacket() const { return packet; }
+
+  void Append(const uint8_t* data, size_t length)
+  {
+    bytes.insert(bytes.end(), data, data+length);
+  }
+
+  size_t Read(uint8_t* buf, size_t max_len, bool& end_of_packet) override
+  {
+    size_t n = std::min(max_len, bytes.size() - pos);
+
+    std::memcpy(buf, bytes.data()+pos, n);
+    pos += n;
+    end_of_packet = packet && pos == bytes.size();
+
+    return n;
+  }
+
+  bool Done() const override { return pos == bytes.size(); }
+};
+
+// Data from a range in a memory mapped file. Pages are released after
+// they have been read, so that memory use stays bounded.
+class MappedFileSource : public DataSource {
+  std::shared_ptr<MappedFile> file;
+  size_t pos;
+  size_t end;
+  size_t released;
+
+public:
+  MappedFileSource(std::shared_ptr<MappedFile> file, size_t offset, size_t length)
+    : file(file)
+    , pos(offset)
+    , end(offset + length)
+    , released(offset)
+  {
+  }
+
+  size_t Read(uint8_t* buf, size_t max_len, bool& end_of_packet) override
+  {
+    size_t n = std::min(max_len, end - pos);
+
+    std::memcpy(buf, file->data()+pos, n);
+    pos += n;
+    released = file->Release(released, pos - released);
+    end_of_packet = false;
+
+    return n;
+  }
+
+  bool Done() const override { return pos == end; }
+};
+
+// Generated test pattern, produced on demand as the simulation consumes it.
+// The same pattern, seed and packet lengths always give the same data, so a
+// second source with the same parameters can be used to check received data.
+//
+// PRBS patterns use the polynomials x^7+x^6+1, x^15+x^14+1 and x^31+x^28+1,
+// with bits packed into bytes MSB first. The seed is the initial LFSR state
+// (a seed of zero is replaced by all ones). The counter pattern is
+// incrementing bytes, starting at the low byte of the seed.
+//
+// With max_packet_length > 0 the data is split into packets with lengths
+// drawn uniformly between min_packet_length and max_packet_length. A length
+// of zero generates data until the source is removed.
+class GeneratorSource : public DataSource {
+public:
+  enum class Pattern { PRBS7, PRBS15, PRBS31, COUNTER };
+
+  static std::optional<Pattern> ParsePattern(const std::string& kind)
+  {
+    if (kind == "prbs7") return Pattern::PRBS7;
+    if (kind == "prbs15") return Pattern::PRBS15;
+    if (kind == "prbs31") return Pattern::PRBS31;
+    if (kind == "counter") return Pattern::COUNTER;
+    return std::nullopt;
+  }
+
+  GeneratorSource(Pattern pattern, uint64_t seed, uint64_t length,
+		  size_t min_packet_length, size_t max_packet_length)
+    : pattern(pattern)
+    , length(length)
+    , minPacketLength(std::max<size_t>(min_packet_length, 1))
+    , maxPacketLength(max_packet_length)
+    , rngState(seed)
+  {
+    switch (pattern) {
+    case Pattern::PRBS7:  SetLfsr(7, 6, seed);   break;
+    case Pattern::PRBS15: SetLfsr(15, 14, seed); break;
+    case Pattern::PRBS31: SetLfsr(31, 28, seed); break;
+    case Pattern::COUNTER:
+      state = seed & 0xFF;
+      break;
+    }
+  }
+
+  size_t Read(uint8_t* buf, size_t max_len, bool& end_of_packet) override
+  {
+    uint64_t n = std::min<uint64_t>(max_len, length > 0 ? length - generated : max_len);
+
+    if (maxPacketLength > 0) {
+      if (packetRemaining == 0) {
+	packetRemaining = NextPacketLength();
+      }
+      n = std::min<uint64_t>(n, packetRemaining);
+      packetRemaining -= n;
+    }
+
+    for (uint64_t i = 0; i < n; i++) {
+      buf[i] = NextByte();
+    }
+
+    generated += n;
+    end_of_packet = maxPacketLength > 0 && n > 0 && (packetRemaining == 0 || Done());
+
+    return n;
+  }
+
+  bool Done() const override { return length > 0 && generated == length; }
+
+  // Number of bytes generated so far
+  uint64_t Generated() const { return generated; }
+
+private:
+  Pattern pattern;
+  uint64_t length;
+  size_t minPacketLength;
+  size_t maxPacketLength;
+
+  uint64_t generated = 0;
+  uint64_t packetRemaining = 0;
+
+  // LFSR state, or counter value
+  uint64_t state = 0;
+  int lfsrBits = 0;
+  int lfsrTap = 0;
+
+  // Random number state for packet lengths
+  uint64_t rngState;
+
+  void SetLfsr(int bits, int tap, uint64_t seed)
+  {
+    uint64_t mask = (uint64_t(1) << bits) - 1;
+
+    lfsrBits = bits;
+    lfsrTap = tap;
+    state = (seed & mask) != 0 ? (seed & mask) : mask;
+  }
+
+  uint8_t NextByte()
+  {
+    if (pattern == Pattern::COUNTER) {
+      return uint8_t(state++);
+    }
+
+    uint64_t mask = (uint64_t(1) << lfsrBits) - 1;
+    uint8_t byte = 0;
+
+    for (int i = 0; i < 8; i++) {
+      uint64_t bit = ((state >> (lfsrBits-1)) ^ (state >> (lfsrTap-1))) & 1;
+      state = ((state << 1) | bit) & mask;
+      byte = (byte << 1) | bit;
+    }
+
+    return byte;
+  }
+
+  // splitmix64
+  size_t NextPacketLength()
+  {
+    uint64_t z = (rngState += 0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    z = z ^ (z >> 31);
+
+    if (maxPacketLength <= minPacketLength) {
+      return maxPacketLength;
+    }
+
+    return minPacketLength + z % (maxPacketLength - minPacketLength + 1);
+  }
+};
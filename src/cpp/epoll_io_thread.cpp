@@ -0,0 +1,155 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "epoll_io_thread.hpp"
+
+constexpr int C_EPOLL_MAX_EVENTS = 16;
+
+EpollIoThread::EpollIoThread(std::string name, std::mutex& mutex,
+			     ReadHandler read_handler, FlushHandler flush_handler)
+  : name(std::move(name))
+  , bridgeMutex(mutex)
+  , readHandler(std::move(read_handler))
+  , flushHandler(std::move(flush_handler))
+{
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  if (epollFd < 0 || eventFd < 0) {
+    std::cerr << this->name << ": Could not create epoll/eventfd: " << std::strerror(errno) << std::endl;
+    return;
+  }
+
+  epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.fd = eventFd;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, eventFd, &ev);
+
+  ioThread = std::thread(&EpollIoThread::IoThread, this);
+}
+
+EpollIoThread::~EpollIoThread()
+{
+  Stop();
+
+  if (eventFd >= 0) close(eventFd);
+  if (epollFd >= 0) close(epollFd);
+}
+
+bool
+EpollIoThread::AddFd(int id, int fd)
+{
+  if (!Running()) {
+    return false;
+  }
+
+  epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.fd = fd;
+
+  if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+    std::cerr << name << ": Could not add fd to epoll: " << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  fds[fd] = Fd{.id = id};
+
+  return true;
+}
+
+void
+EpollIoThread::Wake()
+{
+  uint64_t one = 1;
+  (void)write(eventFd, &one, sizeof(one));
+}
+
+void
+EpollIoThread::Stop()
+{
+  if (ioThread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(bridgeMutex);
+      stop = true;
+    }
+
+    Wake();
+    ioThread.join();
+  }
+}
+
+// Flush buffered data, and wait for the fd to be writable again if some of
+// it could not be written. Called with bridgeMutex locked.
+void
+EpollIoThread::Flush(int fd, Fd& entry)
+{
+  bool wait_writable = flushHandler(entry.id, fd);
+
+  if (wait_writable != entry.wait_writable) {
+    epoll_event ev = {};
+    ev.events = wait_writable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+
+    entry.wait_writable = wait_writable;
+  }
+}
+
+void
+EpollIoThread::IoThread()
+{
+  epoll_event events[C_EPOLL_MAX_EVENTS];
+
+  while (true) {
+    int num_events = epoll_wait(epollFd, events, C_EPOLL_MAX_EVENTS, -1);
+
+    if (num_events < 0 && errno != EINTR) {
+      std::cerr << name << ": epoll_wait failed: " << std::strerror(errno) << std::endl;
+      return;
+    }
+
+    for (int i = 0; i < num_events; i++) {
+      int fd = events[i].data.fd;
+
+      if (fd == eventFd) {
+	uint64_t count;
+	(void)read(eventFd, &count, sizeof(count));
+
+	std::lock_guard<std::mutex> lock(bridgeMutex);
+
+	if (stop) {
+	  return;
+	}
+
+	for (auto& [flush_fd, entry] : fds) {
+	  Flush(flush_fd, entry);
+	}
+	continue;
+      }
+
+      int id = -1;
+
+      {
+	std::lock_guard<std::mutex> lock(bridgeMutex);
+
+	auto it = fds.find(fd);
+
+	if (it != fds.end()) {
+	  id = it->second.id;
+
+	  if (events[i].events & EPOLLOUT) {
+	    Flush(fd, it->second);
+	  }
+	}
+      }
+
+      if (id >= 0 && (events[i].events & EPOLLIN)) {
+	readHandler(id, fd);
+      }
+    }
+  }
+}
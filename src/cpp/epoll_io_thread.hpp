@@ -0,0 +1,70 @@
+#pragma once
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Thread doing non-blocking I/O on a set of file descriptors for a bridge
+// (UartPtyBridge, UdpBridge), waiting on epoll.
+//
+// Each fd is added with an ID (the VVC instance ID). When an fd is
+// readable, the read handler is called without the bridge mutex locked,
+// since it passes the data on to the server, which takes the VVC lock (held
+// by the server while it calls into the bridge). Data to write is buffered
+// by the bridge, and written by the flush handler, which is called with the
+// bridge mutex locked when the thread is woken up with Wake, and when an fd
+// that was full becomes writable again.
+class EpollIoThread {
+public:
+  using ReadHandler = std::function<void(int id, int fd)>;
+
+  // Write as much buffered data to fd as possible. Returns true if data is
+  // left, so the fd must be waited on until it is writable.
+  using FlushHandler = std::function<bool(int id, int fd)>;
+
+  // name is used in error messages. mutex is the bridge mutex, which
+  // protects the buffered data.
+  EpollIoThread(std::string name, std::mutex& mutex, ReadHandler read_handler, FlushHandler flush_handler);
+  ~EpollIoThread();
+
+  EpollIoThread(const EpollIoThread&) = delete;
+  EpollIoThread& operator=(const EpollIoThread&) = delete;
+
+  // False if epoll could not be set up
+  bool Running() const { return ioThread.joinable(); }
+
+  // Wait for fd to be readable. Called with the bridge mutex locked.
+  bool AddFd(int id, int fd);
+
+  // Wake up the thread to flush all fds. Only needed when buffered data
+  // goes from empty to non-empty, since each wake up flushes everything
+  // buffered.
+  void Wake();
+
+  // Stop and join the thread. Must be called before the bridge closes its
+  // fds or destroys the data used by the handlers.
+  void Stop();
+
+private:
+  std::string name;
+  std::mutex& bridgeMutex;
+  ReadHandler readHandler;
+  FlushHandler flushHandler;
+
+  struct Fd {
+    int id;
+    bool wait_writable = false;
+  };
+
+  // Key: fd. Protected by bridgeMutex.
+  std::map<int, Fd> fds;
+
+  int epollFd = -1;
+  int eventFd = -1;
+  bool stop = false;
+  std::thread ioThread;
+
+  void IoThread();
+  void Flush(int fd, Fd& entry);
+};
@@ -0,0 +1,224 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "nlohmann/json.hpp"
+
+// SAX handler for the fast path. Picks out the fields of a TransmitBytes or
+// ReceiveBytes request, with either positional or named params, and parses
+// the data array straight into a reusable buffer. Parsing stops at anything
+// unexpected, and the request is then handled by the normal path instead.
+class FastPathRequest : public nlohmann::json_sax<nlohmann::json> {
+public:
+  std::string jsonrpc;
+  std::string method;
+  nlohmann::json id;
+  std::string vvc_type;
+  int64_t vvc_id = 0;
+  int64_t length = 0;
+  bool all_or_nothing = false;
+  std::vector<uint8_t>& data;
+
+  // One bit per field, set when the field has been parsed
+  enum Field : unsigned {
+    NONE = 0, JSONRPC = 1, METHOD = 2, ID = 4, PARAMS = 8,
+    VVC_TYPE = 16, VVC_ID = 32, DATA = 64, LENGTH = 128, ALL_OR_NOTHING = 256
+  };
+  unsigned fields = NONE;
+
+  explicit FastPathRequest(std::vector<uint8_t>& data)
+    : data(data)
+  {
+  }
+
+  bool null() override { return false; }
+
+  bool boolean(bool val) override
+  {
+    Field f = ValueField(false);
+    if (f != ALL_OR_NOTHING) return false;
+    all_or_nothing = val;
+    return Set(f);
+  }
+
+  bool number_integer(number_integer_t val) override
+  {
+    return Integer(val);
+  }
+
+  bool number_unsigned(number_unsigned_t val) override
+  {
+    if (inData) {
+      if (val > 255) return false;
+      data.push_back(val);
+      return true;
+    }
+    if (val > uint64_t(std::numeric_limits<int64_t>::max())) return false;
+    return Integer(val);
+  }
+
+  bool number_float(number_float_t, const string_t&) override { return false; }
+
+  bool string(string_t& val) override
+  {
+    Field f = ValueField(false);
+    switch (f) {
+    case JSONRPC:  jsonrpc = val; break;
+    case METHOD:   method = val; break;
+    case ID:       id = val; break;
+    case VVC_TYPE: vvc_type = val; break;
+    default:       return false;
+    }
+    return Set(f);
+  }
+
+  bool binary(binary_t&) override { return false; }
+
+  bool start_object(std::size_t) override
+  {
+    depth++;
+    if (depth == 1) return true;
+    if (depth == 2 && currentKey == PARAMS) {
+      namedParams = true;
+      return Set(PARAMS);
+    }
+    return false;
+  }
+
+  bool end_object() override
+  {
+    depth--;
+    currentKey = NONE;
+    return true;
+  }
+
+  bool start_array(std::size_t) override
+  {
+    depth++;
+    if (depth == 2 && currentKey == PARAMS) {
+      namedParams = false;
+      paramIdx = 0;
+      return Set(PARAMS);
+    }
+    if (depth == 3 && ValueField(true) == DATA) {
+      inData = true;
+      return Set(DATA);
+    }
+    return false;
+  }
+
+  bool end_array() override
+  {
+    depth--;
+    if (inData) {
+      inData = false;
+      paramIdx++;
+    } else {
+      currentKey = NONE;
+    }
+    return true;
+  }
+
+  bool key(string_t& val) override
+  {
+    if (depth == 1) {
+      currentKey = (val == "jsonrpc") ? JSONRPC :
+	(val == "method") ? METHOD :
+	(val == "id") ? ID :
+	(val == "params") ? PARAMS : NONE;
+    } else {
+      currentKey = (val == "vvc_type") ? VVC_TYPE :
+	(val == "vvc_id") ? VVC_ID :
+	(val == "data") ? DATA :
+	(val == "length") ? LENGTH :
+	(val == "all_or_nothing") ? ALL_OR_NOTHING : NONE;
+    }
+    return currentKey != NONE;
+  }
+
+  bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override
+  {
+    return false;
+  }
+
+  // True if this is a complete TransmitBytes or ReceiveBytes request
+  bool Valid() const
+  {
+    const unsigned common = JSONRPC | METHOD | ID | PARAMS | VVC_TYPE | VVC_ID;
+
+    if (jsonrpc != "2.0" || vvc_id < std::numeric_limits<int>::min() ||
+	vvc_id > std::numeric_limits<int>::max()) {
+      return false;
+    }
+
+    if (method == "TransmitBytes") {
+      return fields == (common | DATA);
+    } else if (method == "ReceiveBytes") {
+      return fields == (common | LENGTH | ALL_OR_NOTHING) &&
+	length <= std::numeric_limits<int>::max();
+    }
+
+    return false;
+  }
+
+private:
+  int depth = 0;
+  Field currentKey = NONE;
+  bool namedParams = false;
+  bool inData = false;
+  size_t paramIdx = 0;
+
+  // Field that the next value belongs to. Positional params are in the
+  // order vvc_type, vvc_id, data or length, all_or_nothing.
+  Field ValueField(bool is_array) const
+  {
+    if (depth == 1) {
+      return currentKey;
+    }
+
+    // Depth has already been incremented when an array is started
+    if (depth != (is_array ? 3 : 2)) {
+      return NONE;
+    }
+
+    if (namedParams) {
+      return currentKey;
+    }
+
+    switch (paramIdx) {
+    case 0:  return VVC_TYPE;
+    case 1:  return VVC_ID;
+    case 2:  return is_array ? DATA : LENGTH;
+    case 3:  return ALL_OR_NOTHING;
+    default: return NONE;
+    }
+  }
+
+  bool Integer(int64_t val)
+  {
+    Field f = ValueField(false);
+    switch (f) {
+    case ID:     id = val; break;
+    case VVC_ID: vvc_id = val; break;
+    case LENGTH: length = val; break;
+    default:     return false;
+    }
+    return Set(f);
+  }
+
+  // Mark field as parsed. Fields may only appear once.
+  bool Set(Field f)
+  {
+    if (fields & f) {
+      return false;
+    }
+    fields |= f;
+
+    if (depth == 2 && !namedParams && f != PARAMS) {
+      paramIdx++;
+    }
+    return true;
+  }
+};
@@ -0,0 +1,311 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+#ifdef UVVM_COSIM_ZLIB
+#include <zlib.h>
+#endif
+#ifdef UVVM_COSIM_ZSTD
+#include <zstd.h>
+#endif
+
+// HTTP content codings for compressing JSON-RPC requests and responses
+// between hosts. gzip is supported when built with zlib (UVVM_COSIM_ZLIB),
+// and zstd when built with libzstd (UVVM_COSIM_ZSTD). Without either,
+// everything is sent uncompressed.
+//
+// Responses are compressed when the client lists a supported coding in
+// Accept-Encoding. The server lists the codings it supports in an
+// Accept-Encoding header in its responses, and the client then compresses
+// its requests with the best of them.
+enum class ContentCoding { IDENTITY, GZIP, ZSTD };
+
+// Requests and responses smaller than this are not compressed by default,
+// so small control calls don't pay for compression
+constexpr size_t C_COMPRESS_THRESHOLD = 1024;
+
+// Data is passed through the compressor in pieces of this size. The whole
+// compressed body is still built in memory before it is sent.
+constexpr size_t C_COMPRESS_CHUNK = 64 * 1024;
+
+// Max size of decompressed data, so a small compressed request can't
+// exhaust memory
+constexpr size_t C_MAX_DECOMPRESSED_SIZE = size_t(1) << 30;
+
+// JSON arrays of byte values compress well even at the fastest levels
+constexpr int C_GZIP_LEVEL = 1;
+constexpr int C_ZSTD_LEVEL = 1;
+
+inline const char* content_coding_name(ContentCoding coding)
+{
+  switch (coding) {
+  case ContentCoding::GZIP: return "gzip";
+  case ContentCoding::ZSTD: return "zstd";
+  default:                  return "identity";
+  }
+}
+
+inline bool content_coding_supported(ContentCoding coding)
+{
+  switch (coding) {
+#ifdef UVVM_COSIM_ZLIB
+  case ContentCoding::GZIP: return true;
+#endif
+#ifdef UVVM_COSIM_ZSTD
+  case ContentCoding::ZSTD: return true;
+#endif
+  case ContentCoding::IDENTITY: return true;
+  default: return false;
+  }
+}
+
+// Value for an Accept-Encoding header with the supported codings, in order
+// of preference. Empty when built without compression support.
+inline std::string supported_content_codings()
+{
+  std::string codings;
+
+  for (auto coding : {ContentCoding::ZSTD, ContentCoding::GZIP}) {
+    if (content_coding_supported(coding)) {
+      codings += (codings.empty() ? "" : ", ");
+      codings += content_coding_name(coding);
+    }
+  }
+
+  return codings;
+}
+
+// Coding of a Content-Encoding header value. Returns nullopt for codings
+// that are not supported (including several codings applied in sequence).
+inline std::optional<ContentCoding> parse_content_coding(std::string_view value)
+{
+  std::string token;
+
+  for (char c : value) {
+    if (!std::isspace((unsigned char)c)) {
+      token += std::tolower((unsigned char)c);
+    }
+  }
+
+  std::optional<ContentCoding> coding;
+
+  if (token.empty() || token == "identity") {
+    coding = ContentCoding::IDENTITY;
+  } else if (token == "gzip" || token == "x-gzip") {
+    coding = ContentCoding::GZIP;
+  } else if (token == "zstd") {
+    coding = ContentCoding::ZSTD;
+  }
+
+  if (!coding || !content_coding_supported(*coding)) {
+    return std::nullopt;
+  }
+
+  return coding;
+}
+
+// Best supported coding listed in an Accept-Encoding header value, or
+// IDENTITY. Codings with q=0 are not accepted.
+inline ContentCoding negotiate_content_coding(std::string_view accept_encoding)
+{
+  bool accepted[3] = {true, false, false};
+
+  while (!accept_encoding.empty()) {
+    size_t end = accept_encoding.find(',');
+    std::string_view item = accept_encoding.substr(0, end);
+    accept_encoding.remove_prefix(end == std::string_view::npos ? accept_encoding.size() : end + 1);
+
+    std::string_view token = item.substr(0, item.find(';'));
+    std::string_view params = item.substr(token.size());
+    bool zero_q = false;
+
+    if (size_t q = params.find("q="); q != std::string_view::npos) {
+      zero_q = std::strtod(std::string(params.substr(q + 2)).c_str(), nullptr) <= 0.0;
+    }
+
+    if (auto coding = parse_content_coding(token)) {
+      accepted[int(*coding)] = !zero_q;
+    }
+  }
+
+  for (auto coding : {ContentCoding::ZSTD, ContentCoding::GZIP}) {
+    if (accepted[int(coding)]) {
+      return coding;
+    }
+  }
+
+  return ContentCoding::IDENTITY;
+}
+
+// True if data starts with the magic number of the coding. Used to tell if
+// a request body has already been decoded by httplib, which decodes gzip by
+// itself when built with zlib support (JSON never starts with these bytes).
+inline bool has_content_coding_magic(ContentCoding coding, std::string_view data)
+{
+  switch (coding) {
+  case ContentCoding::GZIP: return data.starts_with("\x1f\x8b");
+  case ContentCoding::ZSTD: return data.starts_with("\x28\xb5\x2f\xfd");
+  default:                  return false;
+  }
+}
+
+// Compress in to out with coding. Returns false if the coding is not
+// supported or compression failed.
+inline bool compress_content(ContentCoding coding, std::string_view in, std::string& out)
+{
+  out.clear();
+
+#ifdef UVVM_COSIM_ZLIB
+  if (coding == ContentCoding::GZIP) {
+    z_stream zs = {};
+
+    // 16 added to the window bits for a gzip header
+    if (deflateInit2(&zs, C_GZIP_LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+      return false;
+    }
+
+    size_t pos = 0;
+    int flush;
+    int ret = Z_OK;
+
+    do {
+      size_t n = std::min(C_COMPRESS_CHUNK, in.size() - pos);
+      zs.next_in = (Bytef*)(in.data() + pos);
+      zs.avail_in = n;
+      pos += n;
+      flush = (pos == in.size()) ? Z_FINISH : Z_NO_FLUSH;
+
+      do {
+	size_t out_pos = out.size();
+	out.resize(out_pos + C_COMPRESS_CHUNK);
+	zs.next_out = (Bytef*)(out.data() + out_pos);
+	zs.avail_out = C_COMPRESS_CHUNK;
+	ret = deflate(&zs, flush);
+	out.resize(out.size() - zs.avail_out);
+      } while (ret != Z_STREAM_ERROR && zs.avail_out == 0);
+    } while (ret != Z_STREAM_ERROR && flush != Z_FINISH);
+
+    deflateEnd(&zs);
+    return ret == Z_STREAM_END;
+  }
+#endif
+
+#ifdef UVVM_COSIM_ZSTD
+  if (coding == ContentCoding::ZSTD) {
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+
+    if (cctx == nullptr) {
+      return false;
+    }
+
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, C_ZSTD_LEVEL);
+    ZSTD_CCtx_setPledgedSrcSize(cctx, in.size());
+
+    size_t pos = 0;
+    size_t remaining = 0;
+    ZSTD_EndDirective mode;
+
+    do {
+      size_t n = std::min(C_COMPRESS_CHUNK, in.size() - pos);
+      ZSTD_inBuffer input = {in.data() + pos, n, 0};
+      pos += n;
+      mode = (pos == in.size()) ? ZSTD_e_end : ZSTD_e_continue;
+
+      do {
+	size_t out_pos = out.size();
+	out.resize(out_pos + C_COMPRESS_CHUNK);
+	ZSTD_outBuffer output = {out.data() + out_pos, C_COMPRESS_CHUNK, 0};
+	remaining = ZSTD_compressStream2(cctx, &output, &input, mode);
+	out.resize(out_pos + output.pos);
+      } while (!ZSTD_isError(remaining) &&
+	       (mode == ZSTD_e_end ? remaining != 0 : input.pos != input.size));
+    } while (!ZSTD_isError(remaining) && mode != ZSTD_e_end);
+
+    ZSTD_freeCCtx(cctx);
+    return !ZSTD_isError(remaining);
+  }
+#endif
+
+  if (coding == ContentCoding::IDENTITY) {
+    out.assign(in);
+    return true;
+  }
+
+  return false;
+}
+
+// Decompress in to out. Returns false if the coding is not supported, the
+// data is invalid, or it decompresses to more than max_size bytes.
+inline bool decompress_content(ContentCoding coding, std::string_view in, std::string& out,
+			       size_t max_size = C_MAX_DECOMPRESSED_SIZE)
+{
+  out.clear();
+
+#ifdef UVVM_COSIM_ZLIB
+  if (coding == ContentCoding::GZIP) {
+    z_stream zs = {};
+
+    // 32 added to the window bits to detect gzip or zlib headers
+    if (inflateInit2(&zs, 15 + 32) != Z_OK) {
+      return false;
+    }
+
+    zs.next_in = (Bytef*)in.data();
+    zs.avail_in = in.size();
+    int ret;
+
+    do {
+      size_t out_pos = out.size();
+      out.resize(out_pos + C_COMPRESS_CHUNK);
+      zs.next_out = (Bytef*)(out.data() + out_pos);
+      zs.avail_out = C_COMPRESS_CHUNK;
+      ret = inflate(&zs, Z_NO_FLUSH);
+      out.resize(out.size() - zs.avail_out);
+    } while (ret == Z_OK && out.size() <= max_size);
+
+    inflateEnd(&zs);
+    return ret == Z_STREAM_END && out.size() <= max_size;
+  }
+#endif
+
+#ifdef UVVM_COSIM_ZSTD
+  if (coding == ContentCoding::ZSTD) {
+    ZSTD_DCtx* dctx = ZSTD_createDCtx();
+
+    if (dctx == nullptr) {
+      return false;
+    }
+
+    ZSTD_inBuffer input = {in.data(), in.size(), 0};
+    size_t ret;
+    bool output_full;
+
+    // ret is 0 when a frame is complete. Data left in the decoder is
+    // flushed while the output buffer is filled up.
+    do {
+      size_t out_pos = out.size();
+      out.resize(out_pos + C_COMPRESS_CHUNK);
+      ZSTD_outBuffer output = {out.data() + out_pos, C_COMPRESS_CHUNK, 0};
+      ret = ZSTD_decompressStream(dctx, &output, &input);
+      output_full = (output.pos == output.size);
+      out.resize(out_pos + output.pos);
+    } while (!ZSTD_isError(ret) && ret != 0 && out.size() <= max_size &&
+	     (input.pos < input.size || output_full));
+
+    ZSTD_freeDCtx(dctx);
+    return !ZSTD_isError(ret) && ret == 0 && input.pos == input.size && out.size() <= max_size;
+  }
+#endif
+
+  if (coding == ContentCoding::IDENTITY) {
+    out.assign(in);
+    return true;
+  }
+
+  return false;
+}
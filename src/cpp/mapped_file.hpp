@@ -0,0 +1,87 @@
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only memory mapping of a file. Throws std::runtime_error if the
+// file can't be opened or mapped.
+class MappedFile {
+  const uint8_t* addr = nullptr;
+  size_t length = 0;
+
+public:
+  explicit MappedFile(const std::string& path)
+  {
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+      throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0) {
+      int err = errno;
+      close(fd);
+      throw std::runtime_error("Failed to stat " + path + ": " + std::strerror(err));
+    }
+
+    length = st.st_size;
+
+    if (length > 0) {
+      void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (p == MAP_FAILED) {
+        int err = errno;
+        close(fd);
+        throw std::runtime_error("Failed to mmap " + path + ": " + std::strerror(err));
+      }
+
+      addr = static_cast<const uint8_t*>(p);
+      madvise(p, length, MADV_SEQUENTIAL);
+    }
+
+    // The mapping stays valid after the file is closed
+    close(fd);
+  }
+
+  ~MappedFile()
+  {
+    if (addr) {
+      munmap(const_cast<uint8_t*>(addr), length);
+    }
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const uint8_t* data() const { return addr; }
+  size_t size() const { return length; }
+
+  // Tell the kernel that the pages covering [offset, offset+len) are no
+  // longer needed, so that memory use stays bounded while streaming
+  // through a large file. Only whole pages inside the range are released.
+  // Returns the end of the released range, or offset if no pages were
+  // released.
+  size_t Release(size_t offset, size_t len) const
+  {
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+
+    size_t begin = (offset + page_size - 1) / page_size * page_size;
+    size_t end = (offset + len) / page_size * page_size;
+
+    if (!addr || end <= begin) {
+      return offset;
+    }
+
+    madvise(const_cast<uint8_t*>(addr) + begin, end - begin, MADV_DONTNEED);
+
+    return end;
+  }
+};
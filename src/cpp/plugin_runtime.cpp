@@ -0,0 +1,186 @@
+#include <exception>
+#include <iostream>
+#include <dlfcn.h>
+#include "plugin_runtime.hpp"
+
+// Resolution of time waits, in fs (1 ps)
+constexpr uint64_t C_PLUGIN_TICK = 1000;
+
+constexpr const char* C_PLUGIN_MAIN_SYMBOL = "uvvm_cosim_plugin_main";
+
+PluginRuntime::PluginRuntime(UvvmCosimServer& server, TransmitStageEmptyFn transmit_stage_empty)
+  : server(server)
+  , transmitStageEmpty(std::move(transmit_stage_empty))
+{
+}
+
+PluginRuntime::~PluginRuntime()
+{
+  // The coroutine frames must be destroyed before the code that owns them
+  // is unloaded
+  waiters.clear();
+  ready.clear();
+  tasks.clear();
+
+  if (library) {
+    dlclose(library);
+  }
+}
+
+bool
+PluginRuntime::Load(const std::string& path)
+{
+  library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+
+  if (library == nullptr) {
+    std::cerr << "PluginRuntime: Could not load " << path << ": " << dlerror() << std::endl;
+    return false;
+  }
+
+  pluginMain = reinterpret_cast<PluginMainFn>(dlsym(library, C_PLUGIN_MAIN_SYMBOL));
+
+  if (pluginMain == nullptr) {
+    std::cerr << "PluginRuntime: " << path << " has no " << C_PLUGIN_MAIN_SYMBOL << " function" << std::endl;
+    dlclose(library);
+    library = nullptr;
+    return false;
+  }
+
+  pluginPath = path;
+  std::cout << "Loaded plugin " << path << std::endl;
+
+  return true;
+}
+
+void
+PluginRuntime::Start(uint64_t sim_time)
+{
+  now = sim_time;
+
+  if (pluginMain == nullptr) {
+    return;
+  }
+
+  try {
+    pluginMain(*this);
+  } catch (std::exception &e) {
+    std::cerr << "PluginRuntime: " << pluginPath << " failed to start: " << e.what() << std::endl;
+  }
+}
+
+void
+PluginRuntime::Poll(uint64_t sim_time)
+{
+  now = sim_time;
+
+  timeWaits.Advance(now / C_PLUGIN_TICK, [&](std::coroutine_handle<> handle) {
+    ready.push_back(handle);
+  });
+
+  // Waiters are checked once per Poll, so a task that keeps waiting for a
+  // condition that is already met does not stall the simulation
+  for (auto it = waiters.begin(); it != waiters.end();) {
+    if ((*it)->Ready()) {
+      ready.push_back((*it)->handle);
+      it = waiters.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // Tasks spawned by the resumed tasks are started in the same Poll
+  while (!ready.empty()) {
+    auto resume = std::move(ready);
+    ready.clear();
+
+    for (auto handle : resume) {
+      handle.resume();
+    }
+  }
+
+  ReapTasks();
+}
+
+uint64_t
+PluginRuntime::NextDue() const
+{
+  uint64_t next_due = timeWaits.NextDue();
+
+  return next_due == TimingWheel<std::coroutine_handle<>>::C_NEVER ? next_due : next_due * C_PLUGIN_TICK;
+}
+
+// Remove top level tasks that are done, and report the ones that failed
+void
+PluginRuntime::ReapTasks()
+{
+  for (auto it = tasks.begin(); it != tasks.end();) {
+    if (!it->Done()) {
+      ++it;
+      continue;
+    }
+
+    if (auto exception = it->Handle().promise().exception) {
+      try {
+	std::rethrow_exception(exception);
+      } catch (std::exception &e) {
+	std::cerr << "PluginRuntime: Task failed: " << e.what() << std::endl;
+      } catch (...) {
+	std::cerr << "PluginRuntime: Task failed" << std::endl;
+      }
+    }
+
+    it = tasks.erase(it);
+  }
+}
+
+void
+PluginRuntime::Spawn(PluginTask task)
+{
+  tasks.push_back(std::move(task));
+  ready.push_back(tasks.back().Handle());
+}
+
+uint64_t
+PluginRuntime::SimTime()
+{
+  return now;
+}
+
+bool
+PluginRuntime::HasVvc(const std::string& vvc_type, int vvc_instance_id)
+{
+  return server.HasVvc(vvc_type, vvc_instance_id);
+}
+
+void
+PluginRuntime::TransmitPut(const std::string& vvc_type, int vvc_instance_id,
+			   const uint8_t* data, size_t length, bool end_of_packet)
+{
+  server.TransmitQueuePut(vvc_type, vvc_instance_id, data, length, end_of_packet);
+}
+
+bool
+PluginRuntime::TransmitIdle(const std::string& vvc_type, int vvc_instance_id)
+{
+  return transmitStageEmpty(vvc_type, vvc_instance_id) && server.TransmitQueueEmpty(vvc_type, vvc_instance_id);
+}
+
+size_t
+PluginRuntime::ReceiveGet(const std::string& vvc_type, int vvc_instance_id,
+			  size_t max_bytes, std::vector<uint8_t>& data)
+{
+  return server.ReceiveQueueGet(vvc_type, vvc_instance_id, max_bytes, data);
+}
+
+void
+PluginRuntime::Suspend(PluginWaiter& waiter)
+{
+  waiters.push_back(&waiter);
+}
+
+void
+PluginRuntime::SuspendUntil(uint64_t sim_time, std::coroutine_handle<> handle)
+{
+  // Round up, so the task is never resumed early
+  timeWaits.Schedule((sim_time + C_PLUGIN_TICK - 1) / C_PLUGIN_TICK, handle);
+}
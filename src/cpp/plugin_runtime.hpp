@@ -0,0 +1,80 @@
+#pragma once
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <vector>
+#include "timing_wheel.hpp"
+#include "uvvm_cosim_plugin.hpp"
+#include "uvvm_cosim_server.hpp"
+
+// Runs the coroutines of an in-process test sequencer plugin (see
+// uvvm_cosim_plugin.hpp). The plugin shared object is loaded with dlopen,
+// and its tasks are resumed from the VHPI callbacks by calling Poll at the
+// end of every time step. Waiting for time uses a timing wheel, so the
+// simulation can be woken up at the earliest due time. Other waiters (data
+// received, transmit done) are checked once per Poll.
+//
+// Not thread safe, only used from the simulation thread.
+class PluginRuntime : public PluginContext {
+public:
+  // Returns true if the VHPI side transmit stage of a VVC is empty
+  using TransmitStageEmptyFn = std::function<bool(const std::string& vvc_type, int vvc_instance_id)>;
+
+  PluginRuntime(UvvmCosimServer& server, TransmitStageEmptyFn transmit_stage_empty);
+  ~PluginRuntime();
+
+  PluginRuntime(const PluginRuntime&) = delete;
+  PluginRuntime& operator=(const PluginRuntime&) = delete;
+
+  // Load a plugin shared object. Returns false on failure.
+  bool Load(const std::string& path);
+
+  // Call the entry point of the plugin
+  void Start(uint64_t sim_time);
+
+  // Resume the tasks that are ready at sim_time (in fs)
+  void Poll(uint64_t sim_time);
+
+  // Simulation time of the earliest time wait, or TimingWheel::C_NEVER
+  uint64_t NextDue() const;
+
+  // --------------------------------------------------------------------------
+  // PluginContext
+  // --------------------------------------------------------------------------
+
+  void Spawn(PluginTask task) override;
+  uint64_t SimTime() override;
+  bool HasVvc(const std::string& vvc_type, int vvc_instance_id) override;
+  void TransmitPut(const std::string& vvc_type, int vvc_instance_id,
+		   const uint8_t* data, size_t length, bool end_of_packet) override;
+  bool TransmitIdle(const std::string& vvc_type, int vvc_instance_id) override;
+  size_t ReceiveGet(const std::string& vvc_type, int vvc_instance_id,
+		    size_t max_bytes, std::vector<uint8_t>& data) override;
+  void Suspend(PluginWaiter& waiter) override;
+  void SuspendUntil(uint64_t sim_time, std::coroutine_handle<> handle) override;
+
+private:
+  UvvmCosimServer& server;
+  TransmitStageEmptyFn transmitStageEmpty;
+
+  std::string pluginPath;
+  void* library = nullptr;
+  PluginMainFn pluginMain = nullptr;
+
+  uint64_t now = 0;
+
+  // Top level tasks, kept until done
+  std::list<PluginTask> tasks;
+
+  // Tasks to resume in the current Poll
+  std::vector<std::coroutine_handle<>> ready;
+
+  std::vector<PluginWaiter*> waiters;
+
+  // Tasks waiting for time, in ticks of C_PLUGIN_TICK
+  TimingWheel<std::coroutine_handle<>> timeWaits;
+
+  void ReapTasks();
+};
@@ -0,0 +1,184 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Simulation time stamps for a stream of bytes, stored as chunks of bytes
+// that were transmitted or received at the same time. Each chunk is
+// encoded as two LEB128 varints: the time since the previous chunk, and the
+// number of bytes in the chunk shifted left by one, with an end of packet
+// flag (set when the last byte in the chunk ends a packet) in bit 0. With
+// one chunk per time step, a chunk typically takes 3-6 bytes.
+//
+// Bytes are appended at the back and popped from the front, so the log can
+// follow the data in a queue. Times must not decrease.
+//
+// Not thread safe.
+class TimestampLog {
+public:
+  struct Chunk {
+    uint64_t time;
+    uint64_t num_bytes;
+    bool end_of_packet;
+  };
+
+  // Reads the chunks in the log from the front, without popping them.
+  // Invalidated by changes to the log.
+  class Reader {
+  public:
+    explicit Reader(const TimestampLog& log)
+      : it(log.encoded.begin())
+      , end(log.encoded.end())
+      , time(log.frontBase)
+    {
+    }
+
+    bool Next(Chunk& chunk)
+    {
+      if (it == end) {
+	return false;
+      }
+
+      time += GetVarint(it);
+      uint64_t bytes_eop = GetVarint(it);
+
+      chunk = {time, bytes_eop >> 1, (bytes_eop & 1) != 0};
+      return true;
+    }
+
+  private:
+    std::deque<uint8_t>::const_iterator it;
+    std::deque<uint8_t>::const_iterator end;
+    uint64_t time;
+  };
+
+  // Append num_bytes bytes at time. Merged into the last chunk when it has
+  // the same time and does not end a packet.
+  void Append(uint64_t time, uint64_t num_bytes, bool end_of_packet = false)
+  {
+    if (num_bytes == 0) {
+      return;
+    }
+
+    time = std::max(time, backTime);
+
+    if (!encoded.empty() && time == backTime && !backEndOfPacket) {
+      num_bytes += backBytes;
+      encoded.resize(backPos);
+      PutVarint(encoded, backDelta);
+    } else {
+      backPos = encoded.size();
+      backDelta = time - backTime;
+      PutVarint(encoded, backDelta);
+    }
+
+    PutVarint(encoded, num_bytes << 1 | (end_of_packet ? 1 : 0));
+
+    backTime = time;
+    backBytes = num_bytes;
+    backEndOfPacket = end_of_packet;
+  }
+
+  // Pop num_bytes bytes (or all bytes, when there are fewer) from the
+  // front, and call fn(time, num_bytes) for each chunk they were in
+  template <typename F>
+  void PopFront(uint64_t num_bytes, F&& fn)
+  {
+    while (num_bytes > 0 && !encoded.empty()) {
+      auto it = encoded.cbegin();
+      uint64_t delta = GetVarint(it);
+      uint64_t bytes_eop = GetVarint(it);
+      size_t chunk_len = it - encoded.cbegin();
+      uint64_t chunk_bytes = bytes_eop >> 1;
+      uint64_t n = std::min(num_bytes, chunk_bytes);
+      bool is_back = (backPos == 0);
+
+      fn(frontBase + delta, n);
+      num_bytes -= n;
+
+      encoded.erase(encoded.begin(), encoded.begin() + chunk_len);
+
+      if (n == chunk_bytes) {
+	frontBase += delta;
+
+	if (!is_back) {
+	  backPos -= chunk_len;
+	}
+      } else {
+	// Put back the rest of the chunk
+	std::deque<uint8_t> rest;
+	PutVarint(rest, delta);
+	PutVarint(rest, (chunk_bytes - n) << 1 | (bytes_eop & 1));
+	encoded.insert(encoded.begin(), rest.begin(), rest.end());
+
+	if (is_back) {
+	  backBytes -= n;
+	} else {
+	  backPos = backPos - chunk_len + rest.size();
+	}
+      }
+    }
+  }
+
+  void PopFront(uint64_t num_bytes)
+  {
+    PopFront(num_bytes, [](uint64_t, uint64_t) {});
+  }
+
+  void Clear()
+  {
+    encoded.clear();
+    frontBase = backTime;
+    backPos = 0;
+    backBytes = 0;
+  }
+
+  bool Empty() const
+  {
+    return encoded.empty();
+  }
+
+  // Size of the encoded chunks in bytes
+  size_t EncodedSize() const
+  {
+    return encoded.size();
+  }
+
+private:
+  std::deque<uint8_t> encoded;
+
+  // Time that the delta of the first chunk is relative to
+  uint64_t frontBase = 0;
+
+  // Last chunk: time, position in encoded, delta, and contents
+  uint64_t backTime = 0;
+  size_t backPos = 0;
+  uint64_t backDelta = 0;
+  uint64_t backBytes = 0;
+  bool backEndOfPacket = false;
+
+  static void PutVarint(std::deque<uint8_t>& out, uint64_t val)
+  {
+    while (val >= 0x80) {
+      out.push_back(uint8_t(val) | 0x80);
+      val >>= 7;
+    }
+    out.push_back(uint8_t(val));
+  }
+
+  static uint64_t GetVarint(std::deque<uint8_t>::const_iterator& it)
+  {
+    uint64_t val = 0;
+    int shift = 0;
+
+    while (*it & 0x80) {
+      val |= uint64_t(*it++ & 0x7F) << shift;
+      shift += 7;
+    }
+    val |= uint64_t(*it++) << shift;
+
+    return val;
+  }
+};
@@ -0,0 +1,225 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Hierarchical timing wheel for items scheduled at an absolute time (in
+// ticks). Each level has 256 slots, and each slot on a level spans a full
+// rotation of the level below it. Items are placed on the lowest level where
+// they share the upper time bits with the current time, and are moved down
+// (cascaded) when the current time reaches their slot. Items further away
+// than the top level can hold are kept in an overflow list.
+//
+// Scheduling is O(1), and advancing skips over empty slots, so the cost of
+// advancing does not depend on the distance in time between items.
+//
+// Not thread safe.
+template <typename T>
+class TimingWheel {
+public:
+  static constexpr uint64_t C_NEVER = std::numeric_limits<uint64_t>::max();
+
+  explicit TimingWheel(uint64_t start_time = 0)
+    : current(start_time)
+  {
+  }
+
+  // Schedule item at time. Items scheduled in the past are due immediately.
+  void Schedule(uint64_t time, T item)
+  {
+    Place(Entry{std::max(time, current), std::move(item)});
+    count++;
+  }
+
+  // Advance current time to now, and call fn for every item that is due,
+  // in time order. Items due at the same time are passed in the order
+  // they were scheduled.
+  template <typename F>
+  void Advance(uint64_t now, F&& fn)
+  {
+    while (current <= now) {
+      auto& slot = levels[0][current & C_SLOT_MASK];
+
+      if (!slot.empty()) {
+	auto entries = std::move(slot);
+	slot.clear();
+	ClearBit(0, current & C_SLOT_MASK);
+	count -= entries.size();
+
+	for (auto& entry : entries) {
+	  fn(std::move(entry.item));
+	}
+      }
+
+      if (count == 0 || now == C_NEVER) {
+	current = (now == C_NEVER) ? current + 1 : now + 1;
+	break;
+      }
+
+      Step(now + 1);
+    }
+  }
+
+  // Time of the earliest scheduled item, or C_NEVER when empty
+  uint64_t NextDue() const
+  {
+    if (count == 0) {
+      return C_NEVER;
+    }
+
+    for (int level = 0; level < C_LEVELS; level++) {
+      int shift = C_SLOT_BITS * level;
+      size_t idx = (current >> shift) & C_SLOT_MASK;
+      int next = FindNext(level, level == 0 ? idx : idx + 1);
+
+      if (next >= 0) {
+	uint64_t earliest = C_NEVER;
+	for (auto& entry : levels[level][next]) {
+	  earliest = std::min(earliest, entry.time);
+	}
+	return earliest;
+      }
+    }
+
+    uint64_t earliest = C_NEVER;
+    for (auto& entry : overflow) {
+      earliest = std::min(earliest, entry.time);
+    }
+    return earliest;
+  }
+
+  bool Empty() const
+  {
+    return count == 0;
+  }
+
+  size_t Size() const
+  {
+    return count;
+  }
+
+private:
+  static constexpr int C_LEVELS = 4;
+  static constexpr int C_SLOT_BITS = 8;
+  static constexpr size_t C_SLOTS = 1 << C_SLOT_BITS;
+  static constexpr uint64_t C_SLOT_MASK = C_SLOTS - 1;
+  static constexpr int C_WHEEL_BITS = C_LEVELS * C_SLOT_BITS;
+
+  struct Entry {
+    uint64_t time;
+    T item;
+  };
+
+  std::array<std::array<std::vector<Entry>, C_SLOTS>, C_LEVELS> levels;
+
+  // One bit per slot, set when the slot is non-empty
+  std::array<std::array<uint64_t, C_SLOTS/64>, C_LEVELS> occupied = {};
+
+  std::vector<Entry> overflow;
+
+  // All items before current have been passed to Advance's fn
+  uint64_t current;
+  size_t count = 0;
+
+  void Place(Entry entry)
+  {
+    for (int level = 0; level < C_LEVELS; level++) {
+      int shift = C_SLOT_BITS * (level + 1);
+
+      if ((entry.time >> shift) == (current >> shift)) {
+	size_t idx = (entry.time >> (C_SLOT_BITS * level)) & C_SLOT_MASK;
+	levels[level][idx].push_back(std::move(entry));
+	SetBit(level, idx);
+	return;
+      }
+    }
+
+    overflow.push_back(std::move(entry));
+  }
+
+  // Move current forward to the start of the next non-empty slot, and
+  // cascade that slot to the lower levels. Stops at limit if there is no
+  // non-empty slot before it. The slots passed over are all empty.
+  void Step(uint64_t limit)
+  {
+    for (int level = 0; level < C_LEVELS; level++) {
+      int shift = C_SLOT_BITS * level;
+      size_t idx = (current >> shift) & C_SLOT_MASK;
+      int next = FindNext(level, idx + 1);
+
+      if (next >= 0) {
+	uint64_t rotation = (current >> (shift + C_SLOT_BITS)) << (shift + C_SLOT_BITS);
+	uint64_t target = rotation + (uint64_t(next) << shift);
+
+	if (target > limit) {
+	  current = limit;
+	} else {
+	  current = target;
+	  if (level > 0) {
+	    Cascade(level, next);
+	  }
+	}
+	return;
+      }
+    }
+
+    // Wheel is empty, go to the next top level rotation and re-place the
+    // overflow items that are within reach from there
+    uint64_t target = ((current >> C_WHEEL_BITS) + 1) << C_WHEEL_BITS;
+
+    if (target > limit || target == 0) {
+      current = limit;
+      return;
+    }
+
+    current = target;
+
+    auto entries = std::move(overflow);
+    overflow.clear();
+    for (auto& entry : entries) {
+      Place(std::move(entry));
+    }
+  }
+
+  void Cascade(int level, size_t idx)
+  {
+    auto entries = std::move(levels[level][idx]);
+    levels[level][idx].clear();
+    ClearBit(level, idx);
+
+    for (auto& entry : entries) {
+      Place(std::move(entry));
+    }
+  }
+
+  void SetBit(int level, size_t idx)
+  {
+    occupied[level][idx / 64] |= uint64_t(1) << (idx % 64);
+  }
+
+  void ClearBit(int level, size_t idx)
+  {
+    occupied[level][idx / 64] &= ~(uint64_t(1) << (idx % 64));
+  }
+
+  // Index of first non-empty slot at or after idx on level, -1 if none
+  int FindNext(int level, size_t idx) const
+  {
+    while (idx < C_SLOTS) {
+      uint64_t bits = occupied[level][idx / 64] >> (idx % 64);
+
+      if (bits != 0) {
+	return idx + std::countr_zero(bits);
+      }
+
+      idx = (idx / 64 + 1) * 64;
+    }
+
+    return -1;
+  }
+};
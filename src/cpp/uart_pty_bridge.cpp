@@ -0,0 +1,169 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "uart_pty_bridge.hpp"
+
+// Max number of received bytes buffered for a pty that no tool is reading
+// from. Bytes beyond this are dropped.
+constexpr size_t C_PTY_MAX_BUFFERED = 1024 * 1024;
+
+// Max number of bytes read from a pty at a time
+constexpr size_t C_PTY_READ_CHUNK = 4096;
+
+UartPtyBridge::UartPtyBridge(TransmitHandler transmit_handler)
+  : transmitHandler(std::move(transmit_handler))
+  , ioThread("UartPtyBridge", ptyMutex,
+	     [this](int vvc_instance_id, int fd) { ReadPty(vvc_instance_id, fd); },
+	     [this](int vvc_instance_id, int) { return FlushPty(vvc_instance_id); })
+{
+}
+
+UartPtyBridge::~UartPtyBridge()
+{
+  ioThread.Stop();
+
+  for (auto& [id, pty] : ptys) {
+    close(pty.master_fd);
+    close(pty.slave_fd);
+  }
+}
+
+std::string
+UartPtyBridge::AddUart(int vvc_instance_id)
+{
+  std::lock_guard<std::mutex> lock(ptyMutex);
+
+  if (auto it = ptys.find(vvc_instance_id); it != ptys.end()) {
+    return it->second.path;
+  }
+
+  if (!ioThread.Running()) {
+    return "";
+  }
+
+  int master_fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+
+  if (master_fd < 0 || grantpt(master_fd) != 0 || unlockpt(master_fd) != 0) {
+    std::cerr << "UartPtyBridge: Could not create pty: " << std::strerror(errno) << std::endl;
+    if (master_fd >= 0) close(master_fd);
+    return "";
+  }
+
+  char path[128];
+  ptsname_r(master_fd, path, sizeof(path));
+
+  // Keep the slave side open, so the master does not see a hangup while
+  // no tool has the pty open, and so the raw mode settings are kept
+  int slave_fd = open(path, O_RDWR | O_NOCTTY | O_CLOEXEC);
+
+  if (slave_fd < 0) {
+    std::cerr << "UartPtyBridge: Could not open " << path << ": " << std::strerror(errno) << std::endl;
+    close(master_fd);
+    return "";
+  }
+
+  termios tio;
+  tcgetattr(slave_fd, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(slave_fd, TCSANOW, &tio);
+
+  if (!ioThread.AddFd(vvc_instance_id, master_fd)) {
+    close(slave_fd);
+    close(master_fd);
+    return "";
+  }
+
+  ptys.emplace(vvc_instance_id, Pty{
+      .vvc_instance_id = vvc_instance_id,
+      .master_fd = master_fd,
+      .slave_fd = slave_fd,
+      .path = path
+    });
+
+  std::cout << "UART VVC " << vvc_instance_id << " connected to " << path << std::endl;
+
+  return path;
+}
+
+std::string
+UartPtyBridge::PtyPath(int vvc_instance_id)
+{
+  std::lock_guard<std::mutex> lock(ptyMutex);
+
+  auto it = ptys.find(vvc_instance_id);
+
+  return it != ptys.end() ? it->second.path : "";
+}
+
+bool
+UartPtyBridge::Receive(int vvc_instance_id, uint8_t byte)
+{
+  std::lock_guard<std::mutex> lock(ptyMutex);
+
+  auto it = ptys.find(vvc_instance_id);
+
+  if (it == ptys.end()) {
+    return false;
+  }
+
+  Pty& pty = it->second;
+
+  if (pty.out_buf.size() >= C_PTY_MAX_BUFFERED) {
+    if (!pty.overflow_reported) {
+      std::cerr << "UartPtyBridge: Nothing is reading from " << pty.path;
+      std::cerr << ", dropping received bytes" << std::endl;
+      pty.overflow_reported = true;
+    }
+    return true;
+  }
+
+  pty.out_buf.push_back(byte);
+
+  if (pty.out_buf.size() == 1) {
+    ioThread.Wake();
+  }
+
+  return true;
+}
+
+// Write as much of the buffered received bytes to the pty as possible.
+// Returns true if some are left. Called with ptyMutex locked.
+bool
+UartPtyBridge::FlushPty(int vvc_instance_id)
+{
+  Pty& pty = ptys.at(vvc_instance_id);
+  size_t written = 0;
+
+  while (written < pty.out_buf.size()) {
+    ssize_t n = write(pty.master_fd, &pty.out_buf[written], pty.out_buf.size() - written);
+
+    if (n <= 0) {
+      break;
+    }
+    written += n;
+  }
+
+  pty.out_buf.erase(pty.out_buf.begin(), pty.out_buf.begin() + written);
+
+  if (pty.out_buf.empty()) {
+    pty.overflow_reported = false;
+  }
+
+  return !pty.out_buf.empty();
+}
+
+// Pass bytes written to the pty by a tool on to the transmit handler
+void
+UartPtyBridge::ReadPty(int vvc_instance_id, int master_fd)
+{
+  uint8_t buf[C_PTY_READ_CHUNK];
+  ssize_t n;
+
+  while ((n = read(master_fd, buf, sizeof(buf))) > 0) {
+    transmitHandler(vvc_instance_id, buf, n);
+  }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "epoll_io_thread.hpp"
+
+// Connects UART VVCs to Linux pseudo-terminals, so serial port tools can
+// talk to the simulated UARTs directly. Bytes written to the pty by a tool
+// are passed to a transmit handler (which puts them in the VVC transmit
+// queue), and bytes received by the VVC are written to the pty.
+//
+// All pty I/O is done by an EpollIoThread. Received bytes are buffered
+// until the I/O thread writes them to the pty.
+class UartPtyBridge {
+public:
+  using TransmitHandler = std::function<void(int vvc_instance_id, const uint8_t* data, size_t length)>;
+
+  explicit UartPtyBridge(TransmitHandler transmit_handler);
+  ~UartPtyBridge();
+
+  UartPtyBridge(const UartPtyBridge&) = delete;
+  UartPtyBridge& operator=(const UartPtyBridge&) = delete;
+
+  // Create a pty for a UART VVC (if it does not have one already).
+  // Returns the path of the pty for tools to open, or an empty string
+  // on failure.
+  std::string AddUart(int vvc_instance_id);
+
+  // Path of the pty for a UART VVC, or an empty string if it has none
+  std::string PtyPath(int vvc_instance_id);
+
+  // Queue a byte received by the VVC for writing to its pty.
+  // Returns false if the VVC has no pty.
+  bool Receive(int vvc_instance_id, uint8_t byte);
+
+private:
+  struct Pty {
+    int vvc_instance_id;
+    int master_fd;
+    int slave_fd;
+    std::string path;
+    std::vector<uint8_t> out_buf;
+    bool overflow_reported = false;
+  };
+
+  TransmitHandler transmitHandler;
+
+  // Key: VVC instance ID
+  std::map<int, Pty> ptys;
+  std::mutex ptyMutex;
+
+  // Declared last, so it is constructed after the ptys
+  EpollIoThread ioThread;
+
+  void ReadPty(int vvc_instance_id, int master_fd);
+  bool FlushPty(int vvc_instance_id);
+};
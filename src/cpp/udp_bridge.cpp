@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "udp_bridge.hpp"
+
+// Max payload of a UDP datagram. Packets longer than this are split.
+constexpr size_t C_UDP_MAX_PAYLOAD = 65507;
+
+// Max number of datagrams per recvmmsg/sendmmsg call
+constexpr size_t C_UDP_BATCH = 32;
+
+// Max number of packets queued for sending on a socket. Packets beyond
+// this are dropped.
+constexpr size_t C_UDP_MAX_QUEUED = 4096;
+
+// Socket receive buffer size, to absorb bursts of datagrams while the
+// simulation is busy (limited by net.core.rmem_max)
+constexpr int C_UDP_RCVBUF = 4 * 1024 * 1024;
+
+UdpBridge::UdpBridge(int base_port, TransmitHandler transmit_handler)
+  : basePort(base_port)
+  , transmitHandler(std::move(transmit_handler))
+  , recvBuf(C_UDP_BATCH * C_UDP_MAX_PAYLOAD)
+  , ioThread("UdpBridge", socketMutex,
+	     [this](int vvc_instance_id, int fd) { ReadSocket(vvc_instance_id, fd); },
+	     [this](int vvc_instance_id, int) { return FlushSocket(vvc_instance_id); })
+{
+}
+
+UdpBridge::~UdpBridge()
+{
+  ioThread.Stop();
+
+  for (auto& [id, socket] : sockets) {
+    if (socket.num_oversized > 0) {
+      std::cerr << "UdpBridge: Dropped " << socket.num_oversized << " datagrams longer than ";
+      std::cerr << socket.max_packet_bytes << " bytes on UDP port " << basePort + 2*id << std::endl;
+    }
+
+    close(socket.fd);
+  }
+}
+
+bool
+UdpBridge::AddVvc(int vvc_instance_id, size_t max_packet_bytes)
+{
+  std::lock_guard<std::mutex> lock(socketMutex);
+
+  if (sockets.find(vvc_instance_id) != sockets.end()) {
+    return true;
+  }
+
+  if (!ioThread.Running()) {
+    return false;
+  }
+
+  int rx_port = basePort + 2*vvc_instance_id;
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(rx_port);
+
+  if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    std::cerr << "UdpBridge: Could not bind to UDP port " << rx_port << ": " << std::strerror(errno) << std::endl;
+    if (fd >= 0) close(fd);
+    return false;
+  }
+
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &C_UDP_RCVBUF, sizeof(C_UDP_RCVBUF));
+
+  sockaddr_in dest = addr;
+  dest.sin_port = htons(rx_port + 1);
+
+  if (!ioThread.AddFd(vvc_instance_id, fd)) {
+    close(fd);
+    return false;
+  }
+
+  sockets.emplace(vvc_instance_id, Socket{
+      .vvc_instance_id = vvc_instance_id,
+      .fd = fd,
+      .dest = dest,
+      .max_packet_bytes = std::min(max_packet_bytes, C_UDP_MAX_PAYLOAD)
+    });
+
+  std::cout << "AXISTREAM VVC " << vvc_instance_id << " connected to UDP port " << rx_port;
+  std::cout << " (transmit) and " << rx_port+1 << " (receive)" << std::endl;
+
+  return true;
+}
+
+int
+UdpBridge::RxPort(int vvc_instance_id)
+{
+  std::lock_guard<std::mutex> lock(socketMutex);
+
+  return sockets.find(vvc_instance_id) != sockets.end() ? basePort + 2*vvc_instance_id : 0;
+}
+
+int
+UdpBridge::TxPort(int vvc_instance_id)
+{
+  std::lock_guard<std::mutex> lock(socketMutex);
+
+  return sockets.find(vvc_instance_id) != sockets.end() ? basePort + 2*vvc_instance_id + 1 : 0;
+}
+
+uint64_t
+UdpBridge::NumOversized(int vvc_instance_id)
+{
+  std::lock_guard<std::mutex> lock(socketMutex);
+
+  auto it = sockets.find(vvc_instance_id);
+
+  return it != sockets.end() ? it->second.num_oversized : 0;
+}
+
+bool
+UdpBridge::Receive(int vvc_instance_id, const uint8_t* data, size_t length, bool end_of_packet)
+{
+  std::lock_guard<std::mutex> lock(socketMutex);
+
+  auto it = sockets.find(vvc_instance_id);
+
+  if (it == sockets.end()) {
+    return false;
+  }
+
+  Socket& socket = it->second;
+  bool was_empty = socket.send_queue.empty();
+
+  while (true) {
+    size_t n = std::min(length, C_UDP_MAX_PAYLOAD - socket.packet.size());
+
+    socket.packet.insert(socket.packet.end(), data, data+n);
+    data += n;
+    length -= n;
+
+    bool full = socket.packet.size() == C_UDP_MAX_PAYLOAD;
+
+    if (!full && !end_of_packet) {
+      break;
+    }
+
+    // Packet complete, or too long for one datagram
+    if (socket.packet.empty()) {
+      break;
+    } else if (socket.send_queue.size() < C_UDP_MAX_QUEUED) {
+      socket.send_queue.push_back(std::move(socket.packet));
+    } else if (!socket.overflow_reported) {
+      std::cerr << "UdpBridge: Send queue for UDP port " << ntohs(socket.dest.sin_port);
+      std::cerr << " is full, dropping received packets" << std::endl;
+      socket.overflow_reported = true;
+    }
+
+    socket.packet.clear();
+
+    if (length == 0) {
+      break;
+    }
+  }
+
+  if (was_empty && !socket.send_queue.empty()) {
+    ioThread.Wake();
+  }
+
+  return true;
+}
+
+// Send the queued packets of a socket, in batches. Returns true if some
+// are left because sending would block. Called with socketMutex locked.
+bool
+UdpBridge::FlushSocket(int vvc_instance_id)
+{
+  Socket& socket = sockets.at(vvc_instance_id);
+  mmsghdr msgs[C_UDP_BATCH];
+  iovec iovs[C_UDP_BATCH];
+
+  while (!socket.send_queue.empty()) {
+    size_t batch = std::min(socket.send_queue.size(), C_UDP_BATCH);
+
+    for (size_t i = 0; i < batch; i++) {
+      auto& packet = socket.send_queue[i];
+
+      iovs[i].iov_base = packet.data();
+      iovs[i].iov_len = packet.size();
+
+      msgs[i] = {};
+      msgs[i].msg_hdr.msg_name = &socket.dest;
+      msgs[i].msg_hdr.msg_namelen = sizeof(socket.dest);
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int sent = sendmmsg(socket.fd, msgs, batch, 0);
+
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    } else if (sent < 0) {
+      // Drop the packet that could not be sent
+      std::cerr << "UdpBridge: sendmmsg failed: " << std::strerror(errno) << std::endl;
+      sent = 1;
+    }
+
+    socket.send_queue.erase(socket.send_queue.begin(), socket.send_queue.begin() + sent);
+  }
+
+  if (socket.send_queue.empty()) {
+    socket.overflow_reported = false;
+  }
+
+  return !socket.send_queue.empty();
+}
+
+// Pass received datagrams on to the transmit handler, as one packet each.
+// Oversized datagrams are dropped, and the first one is reported.
+void
+UdpBridge::ReadSocket(int vvc_instance_id, int fd)
+{
+  mmsghdr msgs[C_UDP_BATCH];
+  iovec iovs[C_UDP_BATCH];
+  size_t max_packet_bytes;
+
+  {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    max_packet_bytes = sockets.at(vvc_instance_id).max_packet_bytes;
+  }
+
+  while (true) {
+    for (size_t i = 0; i < C_UDP_BATCH; i++) {
+      iovs[i].iov_base = &recvBuf[i * C_UDP_MAX_PAYLOAD];
+      iovs[i].iov_len = C_UDP_MAX_PAYLOAD;
+
+      msgs[i] = {};
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int received = recvmmsg(fd, msgs, C_UDP_BATCH, MSG_DONTWAIT, nullptr);
+
+    if (received <= 0) {
+      break;
+    }
+
+    for (int i = 0; i < received; i++) {
+      if (msgs[i].msg_len > max_packet_bytes) {
+	std::lock_guard<std::mutex> lock(socketMutex);
+
+	if (sockets.at(vvc_instance_id).num_oversized++ == 0) {
+	  std::cerr << "UdpBridge: Dropping datagram of " << msgs[i].msg_len << " bytes on UDP port ";
+	  std::cerr << basePort + 2*vvc_instance_id << ", max packet size for AXISTREAM VVC ";
+	  std::cerr << vvc_instance_id << " is " << max_packet_bytes << " bytes" << std::endl;
+	}
+      } else if (msgs[i].msg_len > 0) {
+	// Empty datagrams can't be transmitted as AXI-Stream packets
+	transmitHandler(vvc_instance_id, &recvBuf[i * C_UDP_MAX_PAYLOAD], msgs[i].msg_len);
+      }
+    }
+
+    if (size_t(received) < C_UDP_BATCH) {
+      break;
+    }
+  }
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <netinet/in.h>
+#include "epoll_io_thread.hpp"
+
+// Connects packet based VVCs (AXI-Stream) to UDP sockets on localhost, so
+// ordinary socket programs can send and capture traffic. VVC instance N is
+// bound to port base_port+2*N, and each datagram received on that port is
+// passed to a transmit handler as one packet. Datagrams longer than the max
+// packet size of the VVC are dropped (and counted), since the VVC would
+// split them into several packets. Each packet received by the VVC is sent
+// as one datagram to port base_port+2*N+1.
+//
+// All socket I/O is done by an EpollIoThread, using recvmmsg and sendmmsg
+// to handle many datagrams per system call. Packets to send are queued
+// until the I/O thread sends them.
+class UdpBridge {
+public:
+  using TransmitHandler = std::function<void(int vvc_instance_id, const uint8_t* data, size_t length)>;
+
+  UdpBridge(int base_port, TransmitHandler transmit_handler);
+  ~UdpBridge();
+
+  UdpBridge(const UdpBridge&) = delete;
+  UdpBridge& operator=(const UdpBridge&) = delete;
+
+  // Create the socket for a VVC (if it does not have one already), with the
+  // max number of bytes in a packet transmitted by the VVC. Returns false
+  // on failure.
+  bool AddVvc(int vvc_instance_id, size_t max_packet_bytes);
+
+  // Port that datagrams for the VVC to transmit are received on, and port
+  // that packets received by the VVC are sent to. Zero if the VVC has no
+  // socket.
+  int RxPort(int vvc_instance_id);
+  int TxPort(int vvc_instance_id);
+
+  // Number of datagrams dropped because they exceeded the max packet size
+  uint64_t NumOversized(int vvc_instance_id);
+
+  // Add bytes received by the VVC to its current packet, and queue the
+  // packet for sending at end of packet. Returns false if the VVC has no
+  // socket.
+  bool Receive(int vvc_instance_id, const uint8_t* data, size_t length, bool end_of_packet);
+
+private:
+  struct Socket {
+    int vvc_instance_id;
+    int fd;
+    sockaddr_in dest;
+    size_t max_packet_bytes;
+    uint64_t num_oversized = 0;
+    std::vector<uint8_t> packet;
+    std::deque<std::vector<uint8_t>> send_queue;
+    bool overflow_reported = false;
+  };
+
+  int basePort;
+  TransmitHandler transmitHandler;
+
+  // Key: VVC instance ID
+  std::map<int, Socket> sockets;
+  std::mutex socketMutex;
+
+  // Receive buffers for recvmmsg, allocated once
+  std::vector<uint8_t> recvBuf;
+
+  // Declared last, so it is constructed after the sockets
+  EpollIoThread ioThread;
+
+  void ReadSocket(int vvc_instance_id, int fd);
+  bool FlushSocket(int vvc_instance_id);
+};
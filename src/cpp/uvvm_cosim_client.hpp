@@ -29,6 +29,16 @@ public:
     return CallMethod<JsonResponse>(requestId++, "TransmitBytes", {vvc_type, vvc_id, data});
   }
 
+  JsonResponse TransmitBytesAt(std::string vvc_type, int vvc_id, double sim_time_ns, std::vector<uint8_t> data)
+  {
+    return CallMethod<JsonResponse>(requestId++, "TransmitBytesAt", {vvc_type, vvc_id, sim_time_ns, data});
+  }
+
+  JsonResponse TransmitFile(std::string vvc_type, int vvc_id, std::string path, uint64_t offset, uint64_t length)
+  {
+    return CallMethod<JsonResponse>(requestId++, "TransmitFile", {vvc_type, vvc_id, path, offset, length});
+  }
+
   // JsonResponse TransmitPacket(std::string vvc_type, int vvc_id, std::vector<uint8_t> data)
   // {
   // }
@@ -39,7 +49,75 @@ public:
   }
 
   // JsonResponse ReceivePacket(std::string vvc_type, int vvc_id);
+
+  JsonResponse ExpectBytes(std::string vvc_type, int vvc_id, std::vector<uint8_t> data, int max_mismatches)
+  {
+    return CallMethod<JsonResponse>(requestId++, "ExpectBytes", {vvc_type, vvc_id, data, max_mismatches});
+  }
+
+  JsonResponse ExpectFile(std::string vvc_type, int vvc_id, std::string path, uint64_t offset, uint64_t length,
+			  int max_mismatches)
+  {
+    return CallMethod<JsonResponse>(requestId++, "ExpectFile", {vvc_type, vvc_id, path, offset, length, max_mismatches});
+  }
+
+  JsonResponse GetExpectStatus(std::string vvc_type, int vvc_id, bool clear)
+  {
+    return CallMethod<JsonResponse>(requestId++, "GetExpectStatus", {vvc_type, vvc_id, clear});
+  }
+
+  JsonResponse StartGenerator(std::string vvc_type, int vvc_id, std::string kind, uint64_t seed, uint64_t length,
+			      uint64_t min_packet_length, uint64_t max_packet_length)
+  {
+    return CallMethod<JsonResponse>(requestId++, "StartGenerator", {vvc_type, vvc_id, kind, seed, length,
+								     min_packet_length, max_packet_length});
+  }
+
+  JsonResponse StartChecker(std::string vvc_type, int vvc_id, std::string kind, uint64_t seed, uint64_t length,
+			    uint64_t min_packet_length, uint64_t max_packet_length, int max_mismatches)
+  {
+    return CallMethod<JsonResponse>(requestId++, "StartChecker", {vvc_type, vvc_id, kind, seed, length,
+								   min_packet_length, max_packet_length,
+								   max_mismatches});
+  }
+
+  JsonResponse StopGenerator(std::string vvc_type, int vvc_id)
+  {
+    return CallMethod<JsonResponse>(requestId++, "StopGenerator", {vvc_type, vvc_id});
+  }
+
+  JsonResponse EnableTimestamps(std::string vvc_type, int vvc_id, bool enable)
+  {
+    return CallMethod<JsonResponse>(requestId++, "EnableTimestamps", {vvc_type, vvc_id, enable});
+  }
+
+  JsonResponse GetLatencyStats(std::string tx_vvc_type, int tx_vvc_id, std::string rx_vvc_type, int rx_vvc_id,
+			       bool clear)
+  {
+    return CallMethod<JsonResponse>(requestId++, "GetLatencyStats", {tx_vvc_type, tx_vvc_id, rx_vvc_type,
+								      rx_vvc_id, clear});
+  }
   // {
   // }
 
+  JsonResponse TransmitWords(std::string vvc_type, int vvc_id, std::vector<AxisWord> words)
+  {
+    return CallMethod<JsonResponse>(requestId++, "TransmitWords", {vvc_type, vvc_id, words});
+  }
+
+  JsonResponse ReceiveWords(std::string vvc_type, int vvc_id, int num_words, bool all_or_nothing)
+  {
+    return CallMethod<JsonResponse>(requestId++, "ReceiveWords", {vvc_type, vvc_id, num_words, all_or_nothing});
+  }
+
+  JsonResponse WriteRegs(std::string vvc_type, int vvc_id, std::vector<std::pair<uint64_t, uint64_t>> regs)
+  {
+    return CallMethod<JsonResponse>(requestId++, "WriteRegs", {vvc_type, vvc_id, regs});
+  }
+
+  JsonResponse ReadRegs(std::string vvc_type, int vvc_id, std::vector<uint64_t> addr)
+  {
+    return CallMethod<JsonResponse>(requestId++, "ReadRegs", {vvc_type, vvc_id, addr});
+  }
+
 };
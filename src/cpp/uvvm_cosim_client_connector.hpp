@@ -0,0 +1,79 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <jsonrpccxx/common.hpp>
+#include <jsonrpccxx/iclientconnector.hpp>
+#include <cpphttplibconnector.hpp>
+#include "http_compression.hpp"
+
+// HTTP client connector for the JSON-RPC client. Same as the
+// CppHttpLibClientConnector from the json-rpc-cxx examples, except that the
+// connection to the server is kept open between requests, and that it can
+// be shared between threads (requests are sent one at a time).
+//
+// Requests and responses of at least compress_threshold bytes are
+// compressed (0 disables compression). Requests are only compressed once
+// the server has listed the codings it accepts in a response.
+class UvvmCosimClientConnector : public jsonrpccxx::IClientConnector {
+public:
+  UvvmCosimClientConnector(const std::string &host, int port, size_t compress_threshold = C_COMPRESS_THRESHOLD)
+    : httpClient(host, port)
+    , compressThreshold(compress_threshold)
+  {
+    httpClient.set_keep_alive(true);
+
+    // Responses are decoded in Send, for all supported codings
+    httpClient.set_decompress(false);
+  }
+
+  std::string Send(const std::string &request) override
+  {
+    std::lock_guard<std::mutex> lock(clientMutex);
+
+    httplib::Headers headers;
+    std::string accept = supported_content_codings();
+    const std::string* body = &request;
+    std::string compressed;
+
+    // Sent also when compression is disabled, since httplib may otherwise
+    // add its own Accept-Encoding
+    headers.emplace("Accept-Encoding", compressThreshold > 0 && !accept.empty() ? accept : "identity");
+
+    if (compressThreshold > 0 && request.size() >= compressThreshold &&
+	requestCoding != ContentCoding::IDENTITY &&
+	compress_content(requestCoding, request, compressed)) {
+      headers.emplace("Content-Encoding", content_coding_name(requestCoding));
+      body = &compressed;
+    }
+
+    auto res = httpClient.Post("/jsonrpc", headers, *body, "application/json");
+
+    if (!res || res->status != 200) {
+      throw jsonrpccxx::JsonRpcException(-32003, "client connector error, received status != 200");
+    }
+
+    requestCoding = negotiate_content_coding(res->get_header_value("Accept-Encoding"));
+
+    auto coding = parse_content_coding(res->get_header_value("Content-Encoding"));
+
+    if (coding && *coding == ContentCoding::IDENTITY) {
+      return res->body;
+    }
+
+    std::string response;
+
+    if (!coding || !decompress_content(*coding, res->body, response)) {
+      throw jsonrpccxx::JsonRpcException(-32003, "client connector error, could not decode response");
+    }
+
+    return response;
+  }
+
+private:
+  std::mutex clientMutex;
+  httplib::Client httpClient;
+  size_t compressThreshold;
+
+  // Best coding accepted by the server for requests, from its last response
+  ContentCoding requestCoding = ContentCoding::IDENTITY;
+};
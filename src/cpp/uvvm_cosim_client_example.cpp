@@ -156,4 +156,20 @@ int main(int argc, char** argv)
     print_receive_result(res, "UART");
   }
 
+  std::cout << "AXI-Lite: Write some registers..." << std::endl;
+
+  client.WriteRegs("AXILITE_VVC", 0, {{0x00, 0x11111111}, {0x04, 0x22222222},
+                                      {0x08, 0x33333333}, {0x0C, 0x44444444}});
+
+  std::cout << "AXI-Lite: Read back registers..." << std::endl;
+  {
+    auto res = client.ReadRegs("AXILITE_VVC", 0, {0x00, 0x04, 0x08, 0x0C});
+
+    if (!res.success) {
+      std::cout << "AXI-Lite: Read failed: " << res.result["error"] << std::endl;
+    } else {
+      std::cout << "AXI-Lite: Read data = " << res.result["data"] << std::endl;
+    }
+  }
+
 }
@@ -0,0 +1,425 @@
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "nlohmann/json.hpp"
+#include "uvvm_cosim_client_connector.hpp"
+
+// Cosim hub
+//
+// JSON-RPC server that presents the VVCs of several cosim servers (one per
+// simulation) as if they were in one simulation. The VVC lists of all the
+// backend simulations are merged, and the VVCs of each type are given new
+// instance IDs that are unique across the backends. Requests for a VVC are
+// forwarded to the backend with that VVC, with the instance ID translated,
+// over connections to each backend that are kept open. Each request being
+// forwarded has a connection of its own, so a request that blocks in the
+// backend (ReadRegs) does not hold up the others. The requests in a batch
+// request are grouped into one batch request per backend, and the backends
+// are called in parallel.
+//
+// StartSim is sent to all the backends.
+
+using json = nlohmann::json;
+
+constexpr int C_DEFAULT_HUB_PORT = 8484;
+
+// JSON-RPC error code for errors communicating with a backend
+// (same as used by the client connector)
+constexpr int C_BACKEND_ERROR = -32003;
+
+// Connections to a backend. A request takes an idle connection, or opens a
+// new one when all of them are in use.
+class ConnectorPool {
+public:
+  ConnectorPool(std::string host, int port)
+    : host(std::move(host))
+    , port(port)
+  {
+  }
+
+  std::string Send(const std::string& request)
+  {
+    std::unique_ptr<UvvmCosimClientConnector> connector;
+
+    {
+      std::lock_guard<std::mutex> lock(idleMutex);
+
+      if (!idle.empty()) {
+	connector = std::move(idle.back());
+	idle.pop_back();
+      }
+    }
+
+    if (!connector) {
+      connector = std::make_unique<UvvmCosimClientConnector>(host, port);
+    }
+
+    // A connection that failed is not reused
+    std::string response = connector->Send(request);
+
+    std::lock_guard<std::mutex> lock(idleMutex);
+    idle.push_back(std::move(connector));
+
+    return response;
+  }
+
+private:
+  std::string host;
+  int port;
+  std::vector<std::unique_ptr<UvvmCosimClientConnector>> idle;
+  std::mutex idleMutex;
+};
+
+struct Backend {
+  std::string address;
+  std::unique_ptr<ConnectorPool> connectors;
+};
+
+// Where a VVC in the hub's namespace is found
+struct BackendVvc {
+  size_t backend;
+  int vvc_instance_id;
+};
+
+class UvvmCosimHub {
+private:
+  std::vector<Backend> backends;
+
+  // Key: VVC type and instance ID in the hub's namespace
+  std::map<std::pair<std::string, int>, BackendVvc> vvcMap;
+  json vvcList = json::array();
+  std::mutex vvcMapMutex;
+
+  httplib::Server httpServer;
+  int port;
+
+  static json ErrorResponse(const json& id, int code, const std::string& message)
+  {
+    return json{{"jsonrpc", "2.0"}, {"id", id}, {"error", {{"code", code}, {"message", message}}}};
+  }
+
+  static json ResultResponse(const json& id, bool success, const json& result)
+  {
+    return json{{"jsonrpc", "2.0"}, {"id", id}, {"result", {{"success", success}, {"result", result}}}};
+  }
+
+  // Send a request (single or batch) to a backend
+  json SendToBackend(size_t backend, const json& request)
+  {
+    return json::parse(backends[backend].connectors->Send(request.dump()));
+  }
+
+  // Get the VVC lists from all backends, and assign new instance IDs to the
+  // VVCs. IDs are assigned per VVC type, in the order of the backends and
+  // then the instance IDs in each backend. Channels of the same VVC instance
+  // (e.g. UART TX and RX) keep sharing an instance ID.
+  void RefreshVvcList()
+  {
+    std::vector<std::future<json>> lists;
+
+    for (size_t b = 0; b < backends.size(); b++) {
+      lists.push_back(std::async(std::launch::async, [this, b]() {
+	return SendToBackend(b, json{{"jsonrpc", "2.0"}, {"id", 0},
+				     {"method", "GetVvcList"}, {"params", json::array()}});
+      }));
+    }
+
+    std::map<std::pair<std::string, int>, BackendVvc> new_vvc_map;
+    json new_vvc_list = json::array();
+    std::map<std::string, int> next_id;
+
+    for (size_t b = 0; b < backends.size(); b++) {
+      json vvcs;
+
+      try {
+	vvcs = lists[b].get().at("result").at("result");
+      } catch (std::exception &e) {
+	std::cerr << "Hub: Could not get VVC list from " << backends[b].address;
+	std::cerr << ": " << e.what() << std::endl;
+	continue;
+      }
+
+      // Sort on instance ID so the assigned IDs are in the same order
+      std::map<std::pair<std::string, int>, std::vector<json>> backend_vvcs;
+
+      for (auto& vvc : vvcs) {
+	backend_vvcs[{vvc.at("vvc_type"), vvc.at("vvc_instance_id")}].push_back(vvc);
+      }
+
+      for (auto& [key, channels] : backend_vvcs) {
+	int hub_id = next_id[key.first]++;
+
+	new_vvc_map[{key.first, hub_id}] = BackendVvc{.backend = b, .vvc_instance_id = key.second};
+
+	for (auto vvc : channels) {
+	  vvc["vvc_instance_id"] = hub_id;
+	  vvc["backend"] = backends[b].address;
+	  vvc["backend_vvc_instance_id"] = key.second;
+	  new_vvc_list.push_back(vvc);
+	}
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(vvcMapMutex);
+    vvcMap = std::move(new_vvc_map);
+    vvcList = std::move(new_vvc_list);
+  }
+
+  // Find the backend for a request on a VVC, and translate the VVC instance
+  // ID in the request to the backend's. Returns false if the request is not
+  // for a VVC. Throws if the VVC does not exist.
+  bool RouteRequest(json& request, size_t& backend)
+  {
+    json* vvc_type;
+    json* vvc_id;
+
+    auto params = request.find("params");
+
+    if (params == request.end()) {
+      return false;
+    } else if (params->is_array() && params->size() >= 2 &&
+	       (*params)[0].is_string() && (*params)[1].is_number_integer()) {
+      vvc_type = &(*params)[0];
+      vvc_id = &(*params)[1];
+    } else if (params->is_object() && params->contains("vvc_type") && params->contains("vvc_id")) {
+      vvc_type = &(*params)["vvc_type"];
+      vvc_id = &(*params)["vvc_id"];
+    } else {
+      return false;
+    }
+
+    std::pair<std::string, int> key = {*vvc_type, *vvc_id};
+
+    std::unique_lock<std::mutex> lock(vvcMapMutex);
+
+    if (vvcMap.empty()) {
+      lock.unlock();
+      RefreshVvcList();
+      lock.lock();
+    }
+
+    auto it = vvcMap.find(key);
+
+    if (it == vvcMap.end()) {
+      throw std::invalid_argument("VVC with type=" + key.first +
+				  " instance_id=" + std::to_string(key.second) +
+				  " does not exist.");
+    }
+
+    backend = it->second.backend;
+    *vvc_id = it->second.vvc_instance_id;
+
+    return true;
+  }
+
+  // Requests that are not for a VVC are handled by the hub
+  json HandleHubRequest(const json& request)
+  {
+    json id = request.value("id", json());
+    std::string method = request.value("method", "");
+
+    if (method == "GetVvcList") {
+      RefreshVvcList();
+
+      std::lock_guard<std::mutex> lock(vvcMapMutex);
+      return ResultResponse(id, true, vvcList);
+
+    } else if (method == "StartSim") {
+      std::vector<std::future<json>> responses;
+
+      for (size_t b = 0; b < backends.size(); b++) {
+	responses.push_back(std::async(std::launch::async, [this, b, &request]() {
+	  return SendToBackend(b, request);
+	}));
+      }
+
+      bool success = true;
+      for (auto& response : responses) {
+	try {
+	  success = success && response.get().at("result").at("success").get<bool>();
+	} catch (std::exception &e) {
+	  success = false;
+	}
+      }
+
+      return ResultResponse(id, success, json());
+    }
+
+    return ErrorResponse(id, -32601, "method not found: " + method);
+  }
+
+  json HandleSingle(json request)
+  {
+    json id = request.value("id", json());
+    size_t backend;
+
+    try {
+      if (!RouteRequest(request, backend)) {
+	return HandleHubRequest(request);
+      }
+    } catch (std::invalid_argument &e) {
+      return ResultResponse(id, false, json{{"error", e.what()}});
+    }
+
+    try {
+      return SendToBackend(backend, request);
+    } catch (std::exception &e) {
+      return ErrorResponse(id, C_BACKEND_ERROR, backends[backend].address + ": " + e.what());
+    }
+  }
+
+  // The requests for each backend are sent as one batch request, with the
+  // index in the client's batch as ID so the responses can be put back in
+  // the client's order. Notifications (no ID) are not supported in batches.
+  json HandleBatch(const json& batch)
+  {
+    json responses = json::array();
+    std::vector<json> result(batch.size());
+    std::map<size_t, json> backend_batches;
+
+    for (size_t i = 0; i < batch.size(); i++) {
+      json request = batch[i];
+      json id = request.value("id", json());
+      size_t backend;
+
+      try {
+	if (!RouteRequest(request, backend)) {
+	  result[i] = HandleHubRequest(request);
+	  continue;
+	}
+      } catch (std::invalid_argument &e) {
+	result[i] = ResultResponse(id, false, json{{"error", e.what()}});
+	continue;
+      }
+
+      request["id"] = i;
+      backend_batches[backend].push_back(std::move(request));
+    }
+
+    std::map<size_t, std::future<json>> backend_responses;
+
+    for (auto& [backend, requests] : backend_batches) {
+      backend_responses[backend] = std::async(std::launch::async, [this, b = backend, &requests]() {
+	return SendToBackend(b, requests);
+      });
+    }
+
+    for (auto& [backend, future] : backend_responses) {
+      try {
+	for (auto& response : future.get()) {
+	  size_t i = response.at("id");
+	  response["id"] = batch[i].value("id", json());
+	  result[i] = std::move(response);
+	}
+      } catch (std::exception &e) {
+	for (auto& request : backend_batches[backend]) {
+	  size_t i = request.at("id");
+	  result[i] = ErrorResponse(batch[i].value("id", json()), C_BACKEND_ERROR,
+				    backends[backend].address + ": " + e.what());
+	}
+      }
+    }
+
+    for (auto& response : result) {
+      if (!response.is_null()) {
+	responses.push_back(std::move(response));
+      }
+    }
+
+    return responses;
+  }
+
+  void PostAction(const httplib::Request &req, httplib::Response &res)
+  {
+    json response;
+
+    try {
+      json request = json::parse(req.body);
+
+      if (request.is_array() && !request.empty()) {
+	response = HandleBatch(request);
+      } else if (request.is_object()) {
+	response = HandleSingle(std::move(request));
+      } else {
+	response = ErrorResponse(json(), -32600, "invalid request");
+      }
+    } catch (json::parse_error &e) {
+      response = ErrorResponse(json(), -32700, std::string("parse error: ") + e.what());
+    }
+
+    res.status = 200;
+    res.set_content(response.dump(), "application/json");
+  }
+
+public:
+  UvvmCosimHub(int port, const std::vector<std::pair<std::string, int>>& backend_addresses)
+    : port(port)
+  {
+    for (auto& [host, backend_port] : backend_addresses) {
+      backends.push_back(Backend{
+	  .address = host + ":" + std::to_string(backend_port),
+	  .connectors = std::make_unique<ConnectorPool>(host, backend_port)
+	});
+    }
+
+    httpServer.Post("/jsonrpc",
+		    [this](const httplib::Request &req, httplib::Response &res) {
+		      this->PostAction(req, res);
+		    });
+  }
+
+  bool Listen()
+  {
+    return httpServer.listen("localhost", port);
+  }
+};
+
+static void print_usage(const char* prog)
+{
+  std::cerr << "Usage: " << prog << " [-p port] host:port [host:port ...]" << std::endl;
+  std::cerr << "  -p port    Port the hub listens on (default " << C_DEFAULT_HUB_PORT << ")" << std::endl;
+  std::cerr << "  host:port  Address of the cosim server of each simulation" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  int port = C_DEFAULT_HUB_PORT;
+  std::vector<std::pair<std::string, int>> backend_addresses;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+
+    if (arg == "-p" && i+1 < argc) {
+      port = std::atoi(argv[++i]);
+    } else if (auto colon = arg.rfind(':'); colon != std::string::npos && colon > 0) {
+      backend_addresses.push_back({arg.substr(0, colon), std::atoi(arg.substr(colon+1).c_str())});
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (backend_addresses.empty()) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  UvvmCosimHub hub(port, backend_addresses);
+
+  std::cout << "Cosim hub listening on port " << port << " with " << backend_addresses.size();
+  std::cout << " backends" << std::endl;
+
+  if (!hub.Listen()) {
+    std::cerr << "Cosim hub could not listen on port " << port << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
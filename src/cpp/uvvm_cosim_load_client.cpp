@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "uvvm_cosim_client.hpp"
+#include "uvvm_cosim_client_connector.hpp"
+
+// Load generator for the cosim server
+//
+// Runs a number of client threads, each with its own keep-alive connection,
+// that send a random mix of requests to the server at a fixed rate (or as
+// fast as possible) for a given time. Reports the throughput and latency
+// percentiles for each method.
+//
+// With a fixed rate, requests are sent on a fixed schedule and latency is
+// measured from the time each request was scheduled to be sent, so that a
+// slow server is not hidden by the client sending fewer requests.
+
+using Clock = std::chrono::steady_clock;
+
+enum class Method { TransmitBytes, ReceiveBytes, GetVvcList, GetExpectStatus };
+
+static const std::map<std::string, Method> C_METHODS = {
+  {"TransmitBytes", Method::TransmitBytes},
+  {"ReceiveBytes", Method::ReceiveBytes},
+  {"GetVvcList", Method::GetVvcList},
+  {"GetExpectStatus", Method::GetExpectStatus}
+};
+
+struct LoadConfig {
+  std::string host = "localhost";
+  int port = 8484;
+  int threads = 4;
+  double duration_s = 10.0;
+  double rate = 0.0;           // Requests per second per thread, 0 for max
+  size_t payload = 64;         // Bytes per TransmitBytes/ReceiveBytes
+  size_t compress_threshold = C_COMPRESS_THRESHOLD; // 0 to disable compression
+  bool start_sim = false;
+  std::vector<std::pair<std::string, int>> vvcs;
+  std::vector<std::pair<Method, double>> mix = {{Method::TransmitBytes, 1.0}, {Method::ReceiveBytes, 1.0}};
+};
+
+// Results for one method, from one thread or merged
+struct MethodStats {
+  std::vector<uint64_t> latency_ns;
+  uint64_t errors = 0;
+  uint64_t bytes = 0;
+
+  void Merge(const MethodStats& other)
+  {
+    latency_ns.insert(latency_ns.end(), other.latency_ns.begin(), other.latency_ns.end());
+    errors += other.errors;
+    bytes += other.bytes;
+  }
+};
+
+using ThreadStats = std::map<Method, MethodStats>;
+
+static std::string method_name(Method method)
+{
+  for (auto& [name, m] : C_METHODS) {
+    if (m == method) return name;
+  }
+  return "";
+}
+
+static void load_thread(const LoadConfig& cfg, int thread_idx, Clock::time_point start, ThreadStats& stats)
+{
+  UvvmCosimClientConnector connector(cfg.host, cfg.port, cfg.compress_threshold);
+  UvvmCosimClient client(connector);
+
+  std::mt19937 rng(thread_idx);
+  std::vector<double> weights;
+  for (auto& [method, weight] : cfg.mix) {
+    weights.push_back(weight);
+  }
+  std::discrete_distribution<size_t> pick_method(weights.begin(), weights.end());
+  std::uniform_int_distribution<size_t> pick_vvc(0, cfg.vvcs.size() - 1);
+
+  std::vector<uint8_t> payload(cfg.payload);
+  for (size_t i = 0; i < payload.size(); i++) {
+    payload[i] = i;
+  }
+
+  auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(cfg.duration_s));
+  auto interval = cfg.rate > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / cfg.rate))
+                               : Clock::duration::zero();
+
+  // Spread the threads' schedules over one interval
+  auto scheduled = start + interval * thread_idx / cfg.threads;
+
+  while (scheduled < end) {
+    if (cfg.rate > 0) {
+      std::this_thread::sleep_until(scheduled);
+    } else {
+      scheduled = Clock::now();
+    }
+
+    Method method = cfg.mix[pick_method(rng)].first;
+    auto& [vvc_type, vvc_id] = cfg.vvcs[pick_vvc(rng)];
+    auto& method_stats = stats[method];
+    bool success = false;
+
+    try {
+      JsonResponse response;
+
+      switch (method) {
+      case Method::TransmitBytes:
+	response = client.TransmitBytes(vvc_type, vvc_id, payload);
+	if (response.success) {
+	  method_stats.bytes += payload.size();
+	}
+	break;
+      case Method::ReceiveBytes:
+	response = client.ReceiveBytes(vvc_type, vvc_id, cfg.payload, false);
+	if (response.success) {
+	  method_stats.bytes += response.result["data"].size();
+	}
+	break;
+      case Method::GetVvcList:
+	response = client.GetVvcList();
+	break;
+      case Method::GetExpectStatus:
+	response = client.GetExpectStatus(vvc_type, vvc_id, false);
+	break;
+      }
+
+      success = response.success;
+    } catch (std::exception &e) {
+      success = false;
+    }
+
+    method_stats.latency_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - scheduled).count());
+
+    if (!success) {
+      method_stats.errors++;
+    }
+
+    if (cfg.rate > 0) {
+      scheduled += interval;
+    }
+  }
+}
+
+static double percentile_us(const std::vector<uint64_t>& sorted, double p)
+{
+  if (sorted.empty()) {
+    return 0.0;
+  }
+
+  size_t idx = std::min(sorted.size() - 1, size_t(p * sorted.size()));
+
+  return sorted[idx] / 1000.0;
+}
+
+static void print_usage(const char* prog)
+{
+  std::cerr << "Usage: " << prog << " [options]" << std::endl;
+  std::cerr << "  -H host          Server host (default localhost)" << std::endl;
+  std::cerr << "  -p port          Server port (default 8484)" << std::endl;
+  std::cerr << "  -t threads       Number of client threads (default 4)" << std::endl;
+  std::cerr << "  -d seconds       Duration (default 10)" << std::endl;
+  std::cerr << "  -r rate          Requests per second per thread (default 0 = max)" << std::endl;
+  std::cerr << "  -s bytes         Payload size for TransmitBytes/ReceiveBytes (default 64)" << std::endl;
+  std::cerr << "  -c bytes         Compress requests and responses of at least this size" << std::endl;
+  std::cerr << "                   (default " << C_COMPRESS_THRESHOLD << ", 0 = no compression)" << std::endl;
+  std::cerr << "  -v type:id       VVC to send requests to, can be repeated" << std::endl;
+  std::cerr << "                   (default all VVCs from GetVvcList)" << std::endl;
+  std::cerr << "  -m method=weight,...  Request mix (default TransmitBytes=1,ReceiveBytes=1)" << std::endl;
+  std::cerr << "                   Methods: TransmitBytes, ReceiveBytes, GetVvcList, GetExpectStatus" << std::endl;
+  std::cerr << "  -S               Call StartSim before starting" << std::endl;
+}
+
+static bool parse_mix(const std::string& mix_str, LoadConfig& cfg)
+{
+  cfg.mix.clear();
+
+  size_t pos = 0;
+  while (pos < mix_str.size()) {
+    size_t comma = mix_str.find(',', pos);
+    std::string item = mix_str.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+    size_t eq = item.find('=');
+    std::string name = item.substr(0, eq);
+    double weight = eq == std::string::npos ? 1.0 : std::atof(item.substr(eq+1).c_str());
+
+    auto it = C_METHODS.find(name);
+    if (it == C_METHODS.end() || weight <= 0) {
+      std::cerr << "Invalid request mix item: " << item << std::endl;
+      return false;
+    }
+    cfg.mix.push_back({it->second, weight});
+
+    if (comma == std::string::npos) break;
+    pos = comma + 1;
+  }
+
+  return !cfg.mix.empty();
+}
+
+int main(int argc, char** argv)
+{
+  LoadConfig cfg;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = i+1 < argc;
+
+    if (arg == "-H" && has_value) {
+      cfg.host = argv[++i];
+    } else if (arg == "-p" && has_value) {
+      cfg.port = std::atoi(argv[++i]);
+    } else if (arg == "-t" && has_value) {
+      cfg.threads = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "-d" && has_value) {
+      cfg.duration_s = std::atof(argv[++i]);
+    } else if (arg == "-r" && has_value) {
+      cfg.rate = std::atof(argv[++i]);
+    } else if (arg == "-s" && has_value) {
+      cfg.payload = std::atoi(argv[++i]);
+    } else if (arg == "-c" && has_value) {
+      cfg.compress_threshold = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "-v" && has_value) {
+      std::string vvc = argv[++i];
+      size_t colon = vvc.rfind(':');
+      if (colon == std::string::npos) {
+	print_usage(argv[0]);
+	return 1;
+      }
+      cfg.vvcs.push_back({vvc.substr(0, colon), std::atoi(vvc.substr(colon+1).c_str())});
+    } else if (arg == "-m" && has_value) {
+      if (!parse_mix(argv[++i], cfg)) {
+	return 1;
+      }
+    } else if (arg == "-S") {
+      cfg.start_sim = true;
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  UvvmCosimClientConnector connector(cfg.host, cfg.port, cfg.compress_threshold);
+  UvvmCosimClient client(connector);
+
+  try {
+    if (cfg.start_sim) {
+      client.StartSim();
+    }
+
+    if (cfg.vvcs.empty()) {
+      auto vvc_list = client.GetVvcList();
+
+      for (auto& vvc : vvc_list.result) {
+	std::pair<std::string, int> key = {vvc["vvc_type"], vvc["vvc_instance_id"]};
+	if (std::find(cfg.vvcs.begin(), cfg.vvcs.end(), key) == cfg.vvcs.end()) {
+	  cfg.vvcs.push_back(key);
+	}
+      }
+    }
+  } catch (std::exception &e) {
+    std::cerr << "Could not connect to server at " << cfg.host << ":" << cfg.port << ": " << e.what() << std::endl;
+    return 1;
+  }
+
+  if (cfg.vvcs.empty()) {
+    std::cerr << "No VVCs to send requests to" << std::endl;
+    return 1;
+  }
+
+  std::cout << "Running " << cfg.threads << " threads for " << cfg.duration_s << " s";
+  std::cout << " at " << (cfg.rate > 0 ? std::to_string(cfg.rate) + " req/s per thread" : "max rate");
+  std::cout << " on " << cfg.vvcs.size() << " VVCs" << std::endl;
+
+  std::vector<ThreadStats> thread_stats(cfg.threads);
+  std::vector<std::thread> threads;
+  auto start = Clock::now();
+
+  for (int t = 0; t < cfg.threads; t++) {
+    threads.emplace_back(load_thread, std::cref(cfg), t, start, std::ref(thread_stats[t]));
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  double elapsed_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::map<Method, MethodStats> total;
+  for (auto& stats : thread_stats) {
+    for (auto& [method, method_stats] : stats) {
+      total[method].Merge(method_stats);
+    }
+  }
+
+  std::printf("\n%-16s %10s %8s %10s %10s %10s %10s %10s %10s\n",
+	      "method", "requests", "errors", "req/s", "MB/s", "p50 us", "p99 us", "p999 us", "max us");
+
+  for (auto& [method, stats] : total) {
+    std::sort(stats.latency_ns.begin(), stats.latency_ns.end());
+
+    std::printf("%-16s %10zu %8lu %10.1f %10.3f %10.1f %10.1f %10.1f %10.1f\n",
+		method_name(method).c_str(),
+		stats.latency_ns.size(),
+		(unsigned long)stats.errors,
+		stats.latency_ns.size() / elapsed_s,
+		stats.bytes / elapsed_s / 1e6,
+		percentile_us(stats.latency_ns, 0.50),
+		percentile_us(stats.latency_ns, 0.99),
+		percentile_us(stats.latency_ns, 0.999),
+		stats.latency_ns.empty() ? 0.0 : stats.latency_ns.back() / 1000.0);
+  }
+
+  return 0;
+}
@@ -0,0 +1,406 @@
+#pragma once
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// API for in-process test sequencer plugins
+//
+// A plugin is a shared object that is loaded by the VHPI library at the
+// start of simulation (see UVVM_COSIM_PLUGIN in the README). It writes
+// stimulus as C++20 coroutines that talk to the VVCs directly, without
+// going through the JSON-RPC server:
+//
+//   PluginTask run(PluginContext& ctx)
+//   {
+//     auto uart = ctx.Vvc("UART_VVC", 1);
+//
+//     std::vector<uint8_t> data = {0x01, 0x02, 0x03};
+//
+//     co_await uart.Transmit(data);
+//     data = co_await uart.Receive(3);
+//     co_await ctx.Delay(100.0);
+//   }
+//
+//   UVVM_COSIM_PLUGIN_MAIN(ctx)
+//   {
+//     ctx.Spawn(run(ctx));
+//   }
+//
+// The coroutines run on the simulation thread. They are resumed from the
+// VHPI callbacks at the end of a time step, when the condition they wait
+// for has been met, so no locking is needed in plugin code. Data written by
+// a coroutine is picked up by the VVCs from the next time step.
+//
+// The plugin must be built with the same compiler and standard library as
+// the VHPI library, since C++ types are passed between them.
+
+class PluginContext;
+
+// Coroutine type for plugin code. A task is started when it is spawned with
+// PluginContext::Spawn, or when it is awaited from another task.
+class PluginTask {
+public:
+  struct promise_type {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    PluginTask get_return_object()
+    {
+      return PluginTask(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_always initial_suspend() noexcept
+    {
+      return {};
+    }
+
+    // Resume the awaiting task (if any) when done
+    struct FinalAwaiter {
+      bool await_ready() noexcept
+      {
+	return false;
+      }
+
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+      {
+	auto continuation = handle.promise().continuation;
+	return continuation ? continuation : std::noop_coroutine();
+      }
+
+      void await_resume() noexcept
+      {
+      }
+    };
+
+    FinalAwaiter final_suspend() noexcept
+    {
+      return {};
+    }
+
+    void return_void()
+    {
+    }
+
+    void unhandled_exception()
+    {
+      exception = std::current_exception();
+    }
+  };
+
+  PluginTask() = default;
+
+  explicit PluginTask(std::coroutine_handle<promise_type> h)
+    : handle(h)
+  {
+  }
+
+  PluginTask(PluginTask&& other) noexcept
+    : handle(std::exchange(other.handle, nullptr))
+  {
+  }
+
+  PluginTask& operator=(PluginTask&& other) noexcept
+  {
+    if (this != &other) {
+      if (handle) handle.destroy();
+      handle = std::exchange(other.handle, nullptr);
+    }
+    return *this;
+  }
+
+  PluginTask(const PluginTask&) = delete;
+  PluginTask& operator=(const PluginTask&) = delete;
+
+  ~PluginTask()
+  {
+    if (handle) handle.destroy();
+  }
+
+  bool Done() const
+  {
+    return !handle || handle.done();
+  }
+
+  std::coroutine_handle<promise_type> Handle() const
+  {
+    return handle;
+  }
+
+  // Awaiting a task runs it, and resumes the awaiting task when it is done.
+  // Exceptions from the task are rethrown in the awaiting task.
+  auto operator co_await() const noexcept
+  {
+    struct Awaiter {
+      std::coroutine_handle<promise_type> handle;
+
+      bool await_ready() noexcept
+      {
+	return !handle || handle.done();
+      }
+
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+      {
+	handle.promise().continuation = awaiting;
+	return handle;
+      }
+
+      void await_resume()
+      {
+	if (handle && handle.promise().exception) {
+	  std::rethrow_exception(handle.promise().exception);
+	}
+      }
+    };
+
+    return Awaiter{handle};
+  }
+
+private:
+  std::coroutine_handle<promise_type> handle;
+};
+
+// A condition a suspended task waits for. Checked by the plugin runtime
+// at the end of every time step until it is met.
+class PluginWaiter {
+public:
+  virtual ~PluginWaiter() = default;
+
+  virtual bool Ready() = 0;
+
+  std::coroutine_handle<> handle;
+};
+
+// Handle for a VVC, with awaitable operations on its queues
+class PluginVvc {
+public:
+  PluginVvc(PluginContext& ctx, std::string vvc_type, int vvc_instance_id)
+    : ctx(ctx)
+    , vvcType(std::move(vvc_type))
+    , vvcInstanceId(vvc_instance_id)
+  {
+  }
+
+  const std::string& Type() const
+  {
+    return vvcType;
+  }
+
+  int InstanceId() const
+  {
+    return vvcInstanceId;
+  }
+
+  // Queue bytes for transmission. Resumes when the transmit queue of the
+  // VVC has been emptied by the simulation.
+  class TransmitAwaiter : public PluginWaiter {
+  public:
+    TransmitAwaiter(const PluginVvc& vvc, std::vector<uint8_t> data, bool end_of_packet)
+      : ctx(vvc.ctx)
+      , vvcType(vvc.vvcType)
+      , vvcInstanceId(vvc.vvcInstanceId)
+      , data(std::move(data))
+      , endOfPacket(end_of_packet)
+    {
+    }
+
+    bool await_ready()
+    {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h);
+
+    void await_resume()
+    {
+    }
+
+    bool Ready() override;
+
+  private:
+    PluginContext& ctx;
+    std::string vvcType;
+    int vvcInstanceId;
+    std::vector<uint8_t> data;
+    bool endOfPacket;
+  };
+
+  // Wait for length bytes to be received by the VVC, and return them
+  class ReceiveAwaiter : public PluginWaiter {
+  public:
+    ReceiveAwaiter(const PluginVvc& vvc, size_t length)
+      : ctx(vvc.ctx)
+      , vvcType(vvc.vvcType)
+      , vvcInstanceId(vvc.vvcInstanceId)
+      , length(length)
+    {
+    }
+
+    bool await_ready()
+    {
+      return Ready();
+    }
+
+    void await_suspend(std::coroutine_handle<> h);
+
+    std::vector<uint8_t> await_resume()
+    {
+      return std::move(data);
+    }
+
+    bool Ready() override;
+
+  private:
+    PluginContext& ctx;
+    std::string vvcType;
+    int vvcInstanceId;
+    size_t length;
+    std::vector<uint8_t> data;
+  };
+
+  TransmitAwaiter Transmit(std::vector<uint8_t> data)
+  {
+    return TransmitAwaiter(*this, std::move(data), false);
+  }
+
+  // Transmit data as one packet (for packet based VVCs, e.g. AXI-Stream)
+  TransmitAwaiter TransmitPacket(std::vector<uint8_t> data)
+  {
+    return TransmitAwaiter(*this, std::move(data), true);
+  }
+
+  ReceiveAwaiter Receive(size_t length)
+  {
+    return ReceiveAwaiter(*this, length);
+  }
+
+private:
+  PluginContext& ctx;
+  std::string vvcType;
+  int vvcInstanceId;
+};
+
+// Interface to the cosim library, implemented by the plugin runtime.
+// Only to be used from the simulation thread (i.e. from plugin tasks and
+// the plugin entry point).
+class PluginContext {
+public:
+  virtual ~PluginContext() = default;
+
+  // Start a task. It is run at the end of the current time step.
+  virtual void Spawn(PluginTask task) = 0;
+
+  // Current simulation time in fs
+  virtual uint64_t SimTime() = 0;
+
+  // Get a VVC. Throws std::invalid_argument if the VVC does not exist.
+  PluginVvc Vvc(const std::string& vvc_type, int vvc_instance_id)
+  {
+    if (!HasVvc(vvc_type, vvc_instance_id)) {
+      throw std::invalid_argument("VVC with type=" + vvc_type +
+				  " instance_id=" + std::to_string(vvc_instance_id) +
+				  " does not exist.");
+    }
+
+    return PluginVvc(*this, vvc_type, vvc_instance_id);
+  }
+
+  // Wait until a simulation time (in fs) has been reached
+  class TimeAwaiter {
+  public:
+    TimeAwaiter(PluginContext& ctx, uint64_t sim_time)
+      : ctx(ctx)
+      , simTime(sim_time)
+    {
+    }
+
+    bool await_ready()
+    {
+      return ctx.SimTime() >= simTime;
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+      ctx.SuspendUntil(simTime, h);
+    }
+
+    void await_resume()
+    {
+    }
+
+  private:
+    PluginContext& ctx;
+    uint64_t simTime;
+  };
+
+  TimeAwaiter Delay(double ns)
+  {
+    return TimeAwaiter(*this, SimTime() + uint64_t(ns * 1e6));
+  }
+
+  TimeAwaiter WaitUntil(double sim_time_ns)
+  {
+    return TimeAwaiter(*this, uint64_t(sim_time_ns * 1e6));
+  }
+
+  // --------------------------------------------------------------------------
+  // Low level interface used by the awaitables
+  // --------------------------------------------------------------------------
+
+  virtual bool HasVvc(const std::string& vvc_type, int vvc_instance_id) = 0;
+
+  // Queue bytes in the transmit queue of a VVC
+  virtual void TransmitPut(const std::string& vvc_type, int vvc_instance_id,
+			   const uint8_t* data, size_t length, bool end_of_packet) = 0;
+
+  // True when all data queued for transmit on a VVC has been transmitted
+  virtual bool TransmitIdle(const std::string& vvc_type, int vvc_instance_id) = 0;
+
+  // Pop up to max_bytes from the receive queue of a VVC, appending them to
+  // data. Returns the number of bytes popped.
+  virtual size_t ReceiveGet(const std::string& vvc_type, int vvc_instance_id,
+			    size_t max_bytes, std::vector<uint8_t>& data) = 0;
+
+  // Resume waiter.handle once waiter.Ready() returns true
+  virtual void Suspend(PluginWaiter& waiter) = 0;
+
+  // Resume handle at the first time step at or after sim_time (in fs)
+  virtual void SuspendUntil(uint64_t sim_time, std::coroutine_handle<> handle) = 0;
+};
+
+inline void PluginVvc::TransmitAwaiter::await_suspend(std::coroutine_handle<> h)
+{
+  ctx.TransmitPut(vvcType, vvcInstanceId, data.data(), data.size(), endOfPacket);
+  handle = h;
+  ctx.Suspend(*this);
+}
+
+inline bool PluginVvc::TransmitAwaiter::Ready()
+{
+  return ctx.TransmitIdle(vvcType, vvcInstanceId);
+}
+
+inline void PluginVvc::ReceiveAwaiter::await_suspend(std::coroutine_handle<> h)
+{
+  handle = h;
+  ctx.Suspend(*this);
+}
+
+inline bool PluginVvc::ReceiveAwaiter::Ready()
+{
+  if (data.size() < length) {
+    ctx.ReceiveGet(vvcType, vvcInstanceId, length - data.size(), data);
+  }
+
+  return data.size() >= length;
+}
+
+// Entry point of a plugin, called once all VVCs have been reported by the
+// testbench. Typically spawns the plugin's top level tasks.
+using PluginMainFn = void (*)(PluginContext& ctx);
+
+#define UVVM_COSIM_PLUGIN_MAIN(ctx) \
+  extern "C" void uvvm_cosim_plugin_main(PluginContext& ctx)
@@ -0,0 +1,69 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "uvvm_cosim_plugin.hpp"
+
+// Example test sequencer plugin. Loaded by the VHPI library when
+// UVVM_COSIM_PLUGIN is set to the path of the built plugin.
+//
+// Does the same as the example client, with the testbench's loopbacks
+// (AXI-Stream VVC 0 to 1, UART VVC 0 to 1), but runs in the simulator.
+
+static void print_received_data(const std::string& vvc_name, const std::vector<uint8_t>& data)
+{
+  std::cout << vvc_name << ": Got " << data.size() << " bytes. data = [";
+  bool first = true;
+  for (auto &b : data) {
+    if (!first) {
+      std::cout << ",";
+    }
+    std::cout << std::hex << (int)b;
+    first = false;
+  }
+  std::cout << "]" << std::endl << std::dec;
+}
+
+static PluginTask axistream_loopback(PluginContext& ctx)
+{
+  auto tx = ctx.Vvc("AXISTREAM_VVC", 0);
+  auto rx = ctx.Vvc("AXISTREAM_VVC", 1);
+
+  std::vector<uint8_t> packet1 = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+  std::vector<uint8_t> packet2 = {0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C};
+
+  co_await tx.TransmitPacket(packet1);
+  co_await tx.TransmitPacket(packet2);
+
+  auto data = co_await rx.Receive(12);
+  print_received_data("AXI-Stream", data);
+}
+
+static PluginTask uart_loopback(PluginContext& ctx)
+{
+  auto tx = ctx.Vvc("UART_VVC", 0);
+  auto rx = ctx.Vvc("UART_VVC", 1);
+
+  for (uint8_t i = 0; i < 4; i++) {
+    std::vector<uint8_t> bytes = {0xCA, 0xFE, i};
+
+    co_await tx.Transmit(bytes);
+
+    auto data = co_await rx.Receive(3);
+    print_received_data("UART", data);
+
+    co_await ctx.Delay(1000.0);
+  }
+}
+
+static PluginTask run(PluginContext& ctx)
+{
+  co_await axistream_loopback(ctx);
+  co_await uart_loopback(ctx);
+
+  std::cout << "Plugin done at " << ctx.SimTime() / 1000000 << " ns" << std::endl;
+}
+
+UVVM_COSIM_PLUGIN_MAIN(ctx)
+{
+  ctx.Spawn(run(ctx));
+}
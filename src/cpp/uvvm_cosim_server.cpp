@@ -1,10 +1,33 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <map>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 #include "nlohmann/json.hpp"
+#include "fast_path_request.hpp"
 #include "uvvm_cosim_server.hpp"
 
+// Max time ReadRegs waits for the simulation to complete all reads
+constexpr auto C_READ_REGS_TIMEOUT = std::chrono::seconds(10);
+
+// Max number of bytes read from a transmit source into the transmit queue at a time
+constexpr size_t C_TRANSMIT_SOURCE_CHUNK = 4096;
+
+// Resolution of TransmitBytesAt, in simulator time units (fs)
+constexpr uint64_t C_SCHEDULER_TICK = 1000000;
+
+// Request buffers of the fast path larger than this are freed after use
+constexpr size_t C_FAST_PATH_MAX_BUFFER = 16 * 1024 * 1024;
+
+// Max number of expected bytes read from an expect source for each comparison
+constexpr size_t C_EXPECT_SOURCE_CHUNK = 256;
+
 // Split a string by delimiter into substrings.
 // Unnecessary leading/trailing and extra delimiters are removed
 static std::vector<std::string> split_str(std::string str, std::string delim)
@@ -61,277 +84,1741 @@ static std::map<std::string, int> parse_vvc_cfg_str(const std::string& cfg_str)
   return vvc_cfg;
 }
 
-void
-UvvmCosimServer::WaitForStartSim()
+// Number of bytes per data word for VVCs that use the word based
+// queues (VVCs with data_width in config), or zero for VVCs that use
+// the byte queues.
+static size_t get_word_bytes(const VvcInstance& vvc)
 {
-  using namespace std::chrono_literals;
+  auto it = vvc.vvc_cfg.find("data_width");
 
-  while (!startSim) {
-    std::this_thread::sleep_for(10ms);
+  if (it == vvc.vvc_cfg.end()) {
+    return 0;
   }
+
+  return std::clamp<size_t>(it->second/8, 1, C_MAX_WORD_BYTES);
 }
 
-void
-UvvmCosimServer::AddVvc(std::string vvc_type, std::string vvc_channel,
-			int vvc_instance_id, std::string vvc_cfg_str)
+// Pack bytes into words and append them to a word queue. The last word
+// already in the queue is filled up first, unless it is end of packet,
+// so that only the last word in the queue can be partially filled.
+static void push_bytes_to_word_queue(std::deque<AxisWord>& q, size_t word_bytes,
+				     const uint8_t* data, size_t length, bool end_of_packet)
 {
-  auto vvc_cfg = parse_vvc_cfg_str(vvc_cfg_str);
+  size_t pos = 0;
 
-  VvcInstance vvc = {
-    .vvc_type = vvc_type,
-    .vvc_channel = vvc_channel,
-    .vvc_instance_id = vvc_instance_id,
-    .vvc_cfg = vvc_cfg
-  };
+  while (pos < length) {
+    if (q.empty() || q.back().tlast || q.back().num_bytes() >= word_bytes) {
+      q.emplace_back();
+    }
 
-  vvcInstanceMap([&](auto &vvc_map) {
-    if (vvc_map.find(vvc) == vvc_map.end()) {
-      vvc_map.emplace(vvc, VvcQueues());
+    AxisWord& word = q.back();
+    size_t num_bytes = word.num_bytes();
+    size_t n = std::min(word_bytes - num_bytes, length - pos);
+
+    std::memcpy(&word.tdata[num_bytes], data+pos, n);
+    word.tkeep = tkeep_mask(num_bytes + n);
+    pos += n;
+  }
+
+  if (end_of_packet && !q.empty()) {
+    q.back().tlast = true;
+  }
+}
+
+// Number of bytes available in a word queue, counting no further than max_bytes
+static size_t word_queue_bytes(const std::deque<AxisWord>& q, size_t max_bytes)
+{
+  size_t count = 0;
+
+  for (auto it = q.begin(); it != q.end() && count < max_bytes; ++it) {
+    count += it->num_bytes();
+  }
+
+  return count;
+}
+
+// Unpack up to max_bytes from a word queue. If a word is only partially
+// consumed, the remaining bytes are kept at the front of the queue.
+static void pop_bytes_from_word_queue(std::deque<AxisWord>& q, std::vector<uint8_t>& data, size_t max_bytes)
+{
+  while (!q.empty() && data.size() < max_bytes) {
+    AxisWord& word = q.front();
+    size_t num_bytes = word.num_bytes();
+    size_t n = std::min(num_bytes, max_bytes - data.size());
+
+    data.insert(data.end(), word.tdata.begin(), word.tdata.begin()+n);
+
+    if (n == num_bytes) {
+      q.pop_front();
     } else {
-      std::cerr << "VVC with type=" << vvc.vvc_type;
-      std::cerr << " channel=" << vvc.vvc_channel;
-      std::cerr << " instance_id=" << vvc.vvc_instance_id;
-      std::cerr << " exist already." << std::endl;
+      std::memmove(&word.tdata[0], &word.tdata[n], num_bytes - n);
+      word.tkeep = tkeep_mask(num_bytes - n);
     }
-  });
+  }
 }
 
-bool
-UvvmCosimServer::TransmitQueueEmpty(std::string vvc_type,
-				    int vvc_instance_id)
+// Put bytes in the transmit queue of a VVC, which is either
+// byte or word based depending on the VVC
+static void push_transmit_queue(const VvcInstance& vvc, VvcQueues& queues,
+				const uint8_t* data, size_t length, bool end_of_packet)
 {
-  VvcInstance vvc = {
-    .vvc_type = vvc_type,
-    .vvc_channel = (vvc_type == "UART_VVC" ? "TX" : "NA"),
-    .vvc_instance_id = vvc_instance_id
-  };
+  size_t word_bytes = get_word_bytes(vvc);
 
-  bool empty = vvcInstanceMap([&](auto &vvc_map) {
-    if (vvc_map.find(vvc) != vvc_map.end()) {
-      return vvc_map[vvc].transmit_queue.empty();
-    } else {
-      std::cerr << "VVC with";
-      std::cerr << " type=" << vvc.vvc_type;
-      std::cerr << " channel=" << vvc.vvc_channel;
-      std::cerr << " instance_id=" << vvc.vvc_instance_id;
-      std::cerr << " does not exist." << std::endl;
+  if (word_bytes > 0) {
+    push_bytes_to_word_queue(queues.transmit_word_queue, word_bytes,
+			     data, length, end_of_packet);
+  } else {
+    auto& q = queues.transmit_queue;
 
-      return true; // empty
+    // Transform uint8_t elements from data to the
+    // std::pair<uint8_t,bool> elements that go in transmit_queue
+    // and insert to end of that queue. The bool part (end of
+    // packet flag) is only set on the last byte.
+    std::transform(data, data+length, std::back_inserter(q),
+		   [](const uint8_t& byte) {
+		     return std::make_pair(byte, false);
+		   });
+
+    if (end_of_packet && !q.empty()) {
+      q.back().second = true;
     }
-  });
+  }
+}
 
-  return empty;
+// Queue up bytes for transmit. If there are pending transmit sources
+// (e.g. a file), the bytes are queued behind them to keep the order.
+static void queue_transmit_bytes(const VvcInstance& vvc, VvcQueues& queues,
+				 const uint8_t* data, size_t length, bool end_of_packet=false)
+{
+  if (queues.transmit_sources.empty()) {
+    push_transmit_queue(vvc, queues, data, length, end_of_packet);
+    return;
+  }
+
+  if (end_of_packet) {
+    auto packet_source = std::make_unique<BytesSource>(true);
+    packet_source->Append(data, length);
+    queues.transmit_sources.push_back(std::move(packet_source));
+    return;
+  }
+
+  auto* bytes_source = dynamic_cast<BytesSource*>(queues.transmit_sources.back().get());
+
+  if (bytes_source == nullptr || bytes_source->IsPacket()) {
+    queues.transmit_sources.push_back(std::make_unique<BytesSource>());
+    bytes_source = static_cast<BytesSource*>(queues.transmit_sources.back().get());
+  }
+
+  bytes_source->Append(data, length);
 }
 
-std::optional<std::pair<uint8_t, bool>>
-UvvmCosimServer::TransmitQueueGet(std::string vvc_type,
-				  int vvc_instance_id)
+// Read the next chunk from the pending transmit sources when
+// the transmit queue has been emptied by the simulation
+static void refill_transmit_queue(const VvcInstance& vvc, VvcQueues& queues)
 {
-  VvcInstance vvc = {
-    .vvc_type = vvc_type,
-    .vvc_channel = (vvc_type == "UART_VVC" ? "TX" : "NA"),
-    .vvc_instance_id = vvc_instance_id
-  };
+  if (!queues.transmit_queue.empty() || !queues.transmit_word_queue.empty()) {
+    return;
+  }
 
-  std::pair<uint8_t, bool> byte = {};
+  uint8_t buf[C_TRANSMIT_SOURCE_CHUNK];
 
-  vvcInstanceMap([&](auto &vvc_map) {
-    if (vvc_map.find(vvc) != vvc_map.end()) {
+  while (!queues.transmit_sources.empty()) {
+    auto& source = *queues.transmit_sources.front();
+    bool end_of_packet = false;
+    size_t length = source.Read(buf, sizeof(buf), end_of_packet);
 
-      if (!vvc_map[vvc].transmit_queue.empty()) {
-	byte = vvc_map[vvc].transmit_queue.front();
-	vvc_map[vvc].transmit_queue.pop_front();
-      } else {
-        std::cerr << "TransmitBytesQueueGet called on empty queue for VVC with";
-        std::cerr << " type=" << vvc.vvc_type;
-        std::cerr << " channel=" << vvc.vvc_channel;
-        std::cerr << " instance_id=" << vvc.vvc_instance_id;
-        std::cerr << std::endl;
+    push_transmit_queue(vvc, queues, buf, length, end_of_packet);
+
+    if (source.Done()) {
+      queues.transmit_sources.pop_front();
+    }
+
+    if (length > 0) {
+      break;
+    }
+  }
+}
+
+// Compare received data against the pending expect sources for a VVC.
+// Matching and mismatching bytes are both consumed by the comparison, only
+// the details of the first mismatches are kept. Returns the number of bytes
+// from data that were compared. Bytes beyond that (when the expected data
+// ran out) should be queued as normal received data.
+static size_t compare_expected(VvcQueues& queues, const uint8_t* data, size_t length, uint64_t sim_time)
+{
+  auto& status = queues.expect_status;
+  size_t pos = 0;
+
+  while (pos < length && !queues.expect_sources.empty()) {
+    auto& source = *queues.expect_sources.front();
+    uint8_t expected[C_EXPECT_SOURCE_CHUNK];
+    bool end_of_packet = false;
+    size_t n = source.Read(expected, std::min(sizeof(expected), length - pos), end_of_packet);
+
+    // Only look at individual bytes when the chunk differs
+    if (n > 0 && std::memcmp(expected, &data[pos], n) != 0) {
+      for (size_t i = 0; i < n; i++) {
+	if (expected[i] != data[pos+i]) {
+	  status.num_mismatches++;
+
+	  if (status.mismatches.size() < status.max_mismatches) {
+	    status.mismatches.push_back({
+		.offset = status.num_compared + i,
+		.expected = expected[i],
+		.received = data[pos+i],
+		.sim_time = sim_time
+	      });
+	  }
+	}
       }
+    }
 
-    } else {
-      std::cerr << "VVC with";
-      std::cerr << " type=" << vvc.vvc_type;
-      std::cerr << " channel=" << vvc.vvc_channel;
-      std::cerr << " instance_id=" << vvc.vvc_instance_id;
-      std::cerr << " does not exist." << std::endl;
+    status.num_compared += n;
+    pos += n;
 
-      // TODO:
-      // Throw exception?
+    if (source.Done()) {
+      queues.expect_sources.pop_front();
     }
-  });
+  }
 
-  return byte;
+  return pos;
 }
 
-void UvvmCosimServer::ReceiveQueuePut(std::string vvc_type,
-				      int vvc_instance_id,
-				      uint8_t byte, bool end_of_packet)
+// Pop the timestamps of num_bytes bytes popped from the receive queue of a
+// VVC, when timestamps are enabled. If timestamps is set, a pair of offset
+// and time is added to it for each run of bytes received at the same time,
+// where offset is the index in the popped data (starting at offset) of the
+// first byte in the run.
+static void pop_receive_timestamps(VvcQueues& queues, size_t num_bytes, size_t offset,
+				   std::vector<std::pair<size_t, uint64_t>>* timestamps)
 {
-  VvcInstance vvc = {
-    .vvc_type = vvc_type,
-    .vvc_channel = (vvc_type == "UART_VVC" ? "RX" : "NA"),
-    .vvc_instance_id = vvc_instance_id
-  };
+  if (!queues.timestamps_enabled) {
+    return;
+  }
 
-  vvcInstanceMap([&](auto &vvc_map) {
-    if (vvc_map.find(vvc) != vvc_map.end()) {
-      vvc_map[vvc].receive_queue.push_back(std::make_pair(byte, end_of_packet));
-    } else {
-      std::cerr << "VVC with";
-      std::cerr << " type=" << vvc.vvc_type;
-      std::cerr << " channel=" << vvc.vvc_channel;
-      std::cerr << " instance_id=" << vvc.vvc_instance_id;
-      std::cerr << " does not exist." << std::endl;
+  // Bytes queued before timestamps were enabled have no timestamps
+  size_t untimed = std::min<uint64_t>(queues.receive_untimed, num_bytes);
+  queues.receive_untimed -= untimed;
+  offset += untimed;
+
+  queues.receive_timestamps.PopFront(num_bytes - untimed, [&](uint64_t time, uint64_t n) {
+    if (timestamps) {
+      timestamps->emplace_back(offset, time);
     }
+    offset += n;
   });
 }
 
-JsonResponse
-UvvmCosimServer::StartSim()
+// Pop up to length bytes from the receive queue of a VVC into data, for
+// ReceiveBytes. Nothing is popped if all_or_nothing is set and fewer than
+// length bytes are available. Returns the number of bytes that were
+// available (counting no further than length for word queues).
+// Timestamps for the popped bytes are added to timestamps (if set), see
+// pop_receive_timestamps.
+static size_t pop_receive_bytes(const VvcInstance& vvc, VvcQueues& queues, int length,
+				bool all_or_nothing, std::vector<uint8_t>& data,
+				std::vector<std::pair<size_t, uint64_t>>* timestamps = nullptr)
 {
-  startSim=true;
+  size_t max_bytes = std::max(length, 0);
+  size_t size_before = data.size();
+  size_t available;
 
-  JsonResponse response = {
-    .success = false
-  };
+  if (get_word_bytes(vvc) > 0) {
+    auto& q = queues.receive_word_queue;
+    available = word_queue_bytes(q, max_bytes);
 
-  return response;
+    if (available > 0 && !(all_or_nothing && available < max_bytes)) {
+      pop_bytes_from_word_queue(q, data, data.size() + max_bytes);
+    }
+
+  } else {
+    auto& q = queues.receive_queue;
+    available = q.size();
+
+    if (available > 0 && !(all_or_nothing && available < max_bytes)) {
+      auto q_end = q.size() > max_bytes ? q.begin()+max_bytes : q.end();
+
+      // Copy the bytes from the receive_queue elements, stripping away the
+      // end of packet flag (not used for ReceiveBytes)
+      for (auto q_it = q.begin(); q_it != q_end; ++q_it) {
+	data.push_back(q_it->first);
+      }
+
+      q.erase(q.begin(), q_end);
+    }
+  }
+
+  pop_receive_timestamps(queues, data.size() - size_before, 0, timestamps);
+
+  return available;
 }
 
-JsonResponse
-UvvmCosimServer::GetVvcList()
+void
+UvvmCosimServer::PutReceivedBytes(const VvcInstance& vvc, VvcQueues& queues, const uint8_t* data,
+				  const uint8_t* end_of_packet, size_t length, uint64_t sim_time)
 {
-  std::vector<VvcInstance> vec;
+  if (queues.timestamps_enabled) {
+    size_t run_start = 0;
 
-  vvcInstanceMap([&](auto &vvc_map) {
-    for (auto vvc : vvc_map) {
-      vec.push_back(vvc.first);
+    for (size_t i = 0; i < length; i++) {
+      if (end_of_packet[i]) {
+	queues.receive_log.Append(sim_time, i + 1 - run_start, true);
+	run_start = i + 1;
+      }
     }
-  });
+    queues.receive_log.Append(sim_time, length - run_start);
+  }
 
-  JsonResponse response;
-  
-  response.success = true;
-  response.result = json(vec);
+  size_t pos = compare_expected(queues, data, length, sim_time);
+  size_t queue_size_before = queues.receive_queue.size();
 
-  return response;
+  for (; pos < length; pos++) {
+    // Bytes for UART VVCs with a pty are not queued, they are
+    // only available on the pty
+    if (!(uartPtyBridge && vvc.vvc_type == "UART_VVC" &&
+	  uartPtyBridge->Receive(vvc.vvc_instance_id, data[pos]))) {
+      queues.receive_queue.push_back(std::make_pair(data[pos], end_of_packet[pos] != 0));
+    }
+  }
+
+  if (queues.timestamps_enabled) {
+    queues.receive_timestamps.Append(sim_time, queues.receive_queue.size() - queue_size_before);
+  }
 }
 
-JsonResponse
-UvvmCosimServer::TransmitBytes(std::string vvc_type, int vvc_id, std::vector<uint8_t> data)
+void
+UvvmCosimServer::PutReceivedWord(const VvcInstance& vvc, VvcQueues& queues, const AxisWord& word,
+				 uint64_t sim_time)
 {
-  JsonResponse response;
+  size_t num_bytes = word.num_bytes();
+  size_t num_compared = compare_expected(queues, word.tdata.data(), num_bytes, sim_time);
+  size_t num_queued = 0;
+
+  if (num_compared < num_bytes) {
+    AxisWord rest = word;
+
+    // Expected data ended within this word, pass on the remaining bytes
+    if (num_compared > 0) {
+      std::memmove(rest.tdata.data(), &word.tdata[num_compared], num_bytes - num_compared);
+      rest.tkeep = tkeep_mask(num_bytes - num_compared);
+    }
+
+    // Words for AXI-Stream VVCs with a UDP socket are not queued, the
+    // packets are only sent as datagrams
+    if (!(udpBridge && vvc.vvc_type == "AXISTREAM_VVC" &&
+	  udpBridge->Receive(vvc.vvc_instance_id, rest.tdata.data(), rest.num_bytes(), rest.tlast))) {
+      queues.receive_word_queue.push_back(std::move(rest));
+      num_queued = num_bytes - num_compared;
+    }
+  }
+
+  if (queues.timestamps_enabled) {
+    queues.receive_log.Append(sim_time, num_bytes, word.tlast);
+    queues.receive_timestamps.Append(sim_time, num_queued);
+  }
+}
+
+void
+UvvmCosimServer::ReceiveStagePut(ReceiveStageMap& stages, uint64_t sim_time)
+{
+  vvcInstanceMap([&](auto &vvc_map) {
+    for (auto& [key, stage] : stages) {
+      if (stage.empty()) {
+	continue;
+      }
+
+      VvcInstance vvc = {
+	.vvc_type = key.first,
+	.vvc_channel = (key.first == "UART_VVC" ? "RX" : "NA"),
+	.vvc_instance_id = key.second
+      };
+
+      auto it = vvc_map.find(vvc);
+
+      if (it != vvc_map.end()) {
+	PutReceivedBytes(it->first, it->second, stage.data.data(), stage.end_of_packet.data(),
+			 stage.data.size(), sim_time);
+
+	for (auto& word : stage.words) {
+	  PutReceivedWord(it->first, it->second, word, sim_time);
+	}
+      } else {
+	std::cerr << "VVC with";
+	std::cerr << " type=" << vvc.vvc_type;
+	std::cerr << " channel=" << vvc.vvc_channel;
+	std::cerr << " instance_id=" << vvc.vvc_instance_id;
+	std::cerr << " does not exist." << std::endl;
+      }
+
+      stage.data.clear();
+      stage.end_of_packet.clear();
+      stage.words.clear();
+    }
+  });
+}
 
+void
+UvvmCosimServer::TransmitStageFetch(std::string vvc_type, int vvc_instance_id, TransmitStage& stage,
+				    size_t max_bytes)
+{
   VvcInstance vvc = {
     .vvc_type = vvc_type,
     .vvc_channel = (vvc_type == "UART_VVC" ? "TX" : "NA"),
-    .vvc_instance_id = vvc_id
+    .vvc_instance_id = vvc_instance_id
   };
 
   vvcInstanceMap([&](auto &vvc_map) {
-    if (vvc_map.find(vvc) != vvc_map.end()) {
-      auto& q = vvc_map[vvc].transmit_queue;
-      
-      // Transform uint8_t elements from data to the
-      // std::pair<uint8_t,bool> elements that go in transmit_queue
-      // and insert to end of that queue.  The bool part (end of
-      // packet flag) is set to false since it's only used for
-      // TransmitPacket.
-      std::transform(data.begin(), data.end(), std::back_inserter(q),
-                     [](const uint8_t& byte) {
-		       return std::make_pair(byte, false);
-		     });
+    auto it = vvc_map.find(vvc);
 
-      response.success = true;
-      response.result = json{};
+    if (it == vvc_map.end()) {
+      std::cerr << "VVC with";
+      std::cerr << " type=" << vvc.vvc_type;
+      std::cerr << " channel=" << vvc.vvc_channel;
+      std::cerr << " instance_id=" << vvc.vvc_instance_id;
+      std::cerr << " does not exist." << std::endl;
+      return;
+    }
 
-    } else {
-      std::string error_str = "VVC with";
-      error_str += " type=" + vvc.vvc_type;
-      error_str += " channel=" + vvc.vvc_channel;
-      error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
-      error_str += " does not exist.";
-      
-      response.success = false;
-      response.result = json{{"error", error_str}};
+    auto& queues = it->second;
+    size_t fetched = 0;
+
+    while (fetched < max_bytes) {
+      refill_transmit_queue(it->first, queues);
+
+      if (!queues.transmit_queue.empty()) {
+	auto& q = queues.transmit_queue;
+	size_t n = std::min(q.size(), max_bytes - fetched);
+
+	stage.bytes.insert(stage.bytes.end(), q.begin(), q.begin()+n);
+	q.erase(q.begin(), q.begin()+n);
+	fetched += n;
+
+      } else if (!queues.transmit_word_queue.empty()) {
+	auto& q = queues.transmit_word_queue;
+
+	while (!q.empty() && fetched < max_bytes) {
+	  fetched += q.front().num_bytes();
+	  stage.words.push_back(q.front());
+	  q.pop_front();
+	}
+
+      } else {
+	break;
+      }
     }
   });
-
-  return response;
 }
 
-JsonResponse
-UvvmCosimServer::TransmitPacket(std::string vvc_type, int vvc_id, std::vector<uint8_t> data)
+void
+UvvmCosimServer::UartPtyTransmit(int vvc_instance_id, const uint8_t* data, size_t length)
 {
-  JsonResponse response = {
-    .success = false,
-    .result = json{{"error", "Not implemented"}}
+  NoteActivity();
+
+  VvcInstance vvc = {
+    .vvc_type = "UART_VVC",
+    .vvc_channel = "TX",
+    .vvc_instance_id = vvc_instance_id
   };
 
-  return response;
+  vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it != vvc_map.end()) {
+      queue_transmit_bytes(it->first, it->second, data, length);
+    }
+  });
 }
 
-JsonResponse
-UvvmCosimServer::ReceiveBytes(std::string vvc_type, int vvc_id, int length, bool all_or_nothing)
+void
+UvvmCosimServer::UdpTransmit(int vvc_instance_id, const uint8_t* data, size_t length)
 {
-  JsonResponse response;
+  NoteActivity();
 
   VvcInstance vvc = {
-    .vvc_type = vvc_type,
-    .vvc_channel = (vvc_type == "UART_VVC" ? "RX" : "NA"),
-    .vvc_instance_id = vvc_id
+    .vvc_type = "AXISTREAM_VVC",
+    .vvc_channel = "NA",
+    .vvc_instance_id = vvc_instance_id
   };
 
   vvcInstanceMap([&](auto &vvc_map) {
-    if (vvc_map.find(vvc) != vvc_map.end()) {
-      std::vector<uint8_t> data;
-      auto& q = vvc_map[vvc].receive_queue;
-
-      if (q.empty() || (all_or_nothing && q.size() < length)) {
-        std::cout << "Server: " << "ReceiveBytes called with length=" << length;
-	std::cout << " and all_or_nothing=" << (all_or_nothing ? "true" : "false");
-	std::cout << ". Returning none, queue size = " << q.size() << std::endl;
-      } else {
-	auto q_end = q.size() > length ? q.begin()+length : q.end();
-
-	// Transform and copy std::pair<uint8_t,bool> elements from
-	// receive_queue to data vector, stripping away the bool in
-	// the pair (which indicates end of packet, not used for
-	// ReceiveBytes).
-	std::transform(q.begin(), q_end, std::back_inserter(data),
-		       [](auto q_elem){
-			 return q_elem.first;
-		       });
-
-	std::cout << "Server: " << "ReceiveBytes called with length=" << length;
-	std::cout << " and all_or_nothing=" << (all_or_nothing ? "true" : "false");
-	std::cout << ". Returning " << data.size() << " of " << q.size();
-	std::cout << " available bytes in queue" << std::endl;
-
-        q.erase(q.begin(), q_end);
-      }
-
-      response.success = true;
-      response.result = json{{"data", data}};
+    auto it = vvc_map.find(vvc);
 
-    } else {
-      std::string error_str = "VVC with";
-      error_str += " type=" + vvc.vvc_type;
-      error_str += " channel=" + vvc.vvc_channel;
-      error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
-      error_str += " does not exist.";
-      
-      response.success = false;
-      response.result = json{{"error", error_str}};
+    if (it != vvc_map.end()) {
+      queue_transmit_bytes(it->first, it->second, data, length, true);
     }
   });
-
-  return response;
 }
 
-JsonResponse
-UvvmCosimServer::ReceivePacket(std::string vvc_type, int vvc_id)
+void
+UvvmCosimServer::AdvanceScheduler(uint64_t sim_time)
+{
+  schedulerEarliest.store(sim_time + 1, std::memory_order_relaxed);
+
+  if (sim_time < schedulerNextDue) {
+    return;
+  }
+
+  std::vector<ScheduledTransmit> due;
+
+  {
+    std::lock_guard<std::mutex> lock(schedulerMutex);
+
+    transmitScheduler.Advance(sim_time / C_SCHEDULER_TICK, [&](ScheduledTransmit transmit) {
+      due.push_back(std::move(transmit));
+    });
+
+    uint64_t next_due = transmitScheduler.NextDue();
+    schedulerNextDue = (next_due == TimingWheel<ScheduledTransmit>::C_NEVER) ? next_due : next_due * C_SCHEDULER_TICK;
+  }
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    for (auto& transmit : due) {
+      auto it = vvc_map.find(transmit.vvc);
+
+      if (it != vvc_map.end()) {
+	queue_transmit_bytes(it->first, it->second, transmit.data.data(), transmit.data.size());
+      }
+    }
+  });
+}
+
+void
+UvvmCosimServer::WaitForStartSim()
+{
+  using namespace std::chrono_literals;
+
+  while (!startSim) {
+    std::this_thread::sleep_for(10ms);
+  }
+}
+
+static int64_t steady_time_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void
+UvvmCosimServer::NoteActivity()
+{
+  lastActivity = steady_time_ns();
+  activityCount++;
+
+  if (idleSuspended) {
+    // Take the lock so the notification can't be lost between the
+    // simulation checking activityCount and starting to wait
+    { std::lock_guard<std::mutex> lock(idleMutex); }
+    idleCv.notify_all();
+  }
+}
+
+bool
+UvvmCosimServer::QueuesIdle()
+{
+  return vvcInstanceMap([&](auto &vvc_map) {
+    for (auto& [vvc, queues] : vvc_map) {
+      if (!queues.transmit_queue.empty() || !queues.transmit_word_queue.empty() ||
+	  !queues.transmit_sources.empty() || !queues.expect_sources.empty() ||
+	  !queues.reg_queue.empty() || !queues.reg_read_pending.empty()) {
+	return false;
+      }
+    }
+    return true;
+  });
+}
+
+void
+UvvmCosimServer::SuspendIfIdle()
+{
+  int64_t now = steady_time_ns();
+
+  if (!IdleSuspendEnabled() || now - lastActivity < idleSuspendWindow.count()) {
+    return;
+  }
+
+  uint64_t count = activityCount;
+
+  if (schedulerNextDue != TimingWheel<ScheduledTransmit>::C_NEVER || !QueuesIdle()) {
+    // Still busy without requests (e.g. transmitting a large file).
+    // Check again after another window instead of every time step.
+    lastActivity = now;
+    return;
+  }
+
+  std::cout << "UvvmCosimServer: No activity for " << idleSuspendWindow.count() / 1000000
+	    << " ms, suspending simulation" << std::endl;
+
+  idleSuspended = true;
+
+  {
+    std::unique_lock<std::mutex> lock(idleMutex);
+    idleCv.wait(lock, [&]() { return activityCount != count; });
+  }
+
+  idleSuspended = false;
+
+  std::cout << "UvvmCosimServer: Resuming simulation" << std::endl;
+}
+
+void
+UvvmCosimServer::AddVvc(std::string vvc_type, std::string vvc_channel,
+			int vvc_instance_id, std::string vvc_cfg_str,
+			std::optional<bool> is_master)
+{
+  auto vvc_cfg = parse_vvc_cfg_str(vvc_cfg_str);
+
+  if (is_master) {
+    vvc_cfg["is_master"] = is_master.value() ? 1 : 0;
+  }
+
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = vvc_channel,
+    .vvc_instance_id = vvc_instance_id,
+    .vvc_cfg = vvc_cfg
+  };
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    if (vvc_map.find(vvc) == vvc_map.end()) {
+      vvc_map.emplace(vvc, VvcQueues());
+
+      if (uartPtyBridge && vvc.vvc_type == "UART_VVC") {
+	uartPtyBridge->AddUart(vvc.vvc_instance_id);
+      }
+
+      if (udpBridge && vvc.vvc_type == "AXISTREAM_VVC") {
+	// Datagrams are not limited by the VVC if it did not report its max
+	// packet size
+	auto max_packet_bytes = vvc.vvc_cfg.find("max_packet_bytes");
+
+	udpBridge->AddVvc(vvc.vvc_instance_id,
+			  max_packet_bytes != vvc.vvc_cfg.end() && max_packet_bytes->second > 0
+			  ? size_t(max_packet_bytes->second) : std::numeric_limits<size_t>::max());
+      }
+    } else {
+      std::cerr << "VVC with type=" << vvc.vvc_type;
+      std::cerr << " channel=" << vvc.vvc_channel;
+      std::cerr << " instance_id=" << vvc.vvc_instance_id;
+      std::cerr << " exist already." << std::endl;
+    }
+  });
+}
+
+bool
+UvvmCosimServer::TransmitQueueEmpty(std::string vvc_type,
+				    int vvc_instance_id)
+{
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = (vvc_type == "UART_VVC" ? "TX" : "NA"),
+    .vvc_instance_id = vvc_instance_id
+  };
+
+  bool empty = vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it != vvc_map.end()) {
+      refill_transmit_queue(it->first, it->second);
+
+      return it->second.transmit_queue.empty() && it->second.transmit_word_queue.empty();
+    } else {
+      std::cerr << "VVC with";
+      std::cerr << " type=" << vvc.vvc_type;
+      std::cerr << " channel=" << vvc.vvc_channel;
+      std::cerr << " instance_id=" << vvc.vvc_instance_id;
+      std::cerr << " does not exist." << std::endl;
+
+      return true; // empty
+    }
+  });
+
+  return empty;
+}
+
+bool
+UvvmCosimServer::HasVvc(std::string vvc_type, int vvc_instance_id)
+{
+  return vvcInstanceMap([&](auto &vvc_map) {
+    for (auto& channel : {"NA", "TX", "RX"}) {
+      VvcInstance vvc = {
+	.vvc_type = vvc_type,
+	.vvc_channel = channel,
+	.vvc_instance_id = vvc_instance_id
+      };
+
+      if (vvc_map.find(vvc) != vvc_map.end()) {
+	return true;
+      }
+    }
+
+    return false;
+  });
+}
+
+bool
+UvvmCosimServer::IsPacketBridged(std::string vvc_type, int vvc_instance_id)
+{
+  return udpBridge && vvc_type == "AXISTREAM_VVC" && udpBridge->TxPort(vvc_instance_id) != 0;
+}
+
+bool
+UvvmCosimServer::TransmitQueuePut(std::string vvc_type, int vvc_instance_id, const uint8_t* data,
+				  size_t length, bool end_of_packet)
+{
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = (vvc_type == "UART_VVC" ? "TX" : "NA"),
+    .vvc_instance_id = vvc_instance_id
+  };
+
+  return vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it == vvc_map.end()) {
+      return false;
+    }
+
+    queue_transmit_bytes(it->first, it->second, data, length, end_of_packet);
+
+    return true;
+  });
+}
+
+size_t
+UvvmCosimServer::ReceiveQueueGet(std::string vvc_type, int vvc_instance_id, size_t max_bytes,
+				 std::vector<uint8_t>& data)
+{
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = (vvc_type == "UART_VVC" ? "RX" : "NA"),
+    .vvc_instance_id = vvc_instance_id
+  };
+
+  return vvcInstanceMap([&](auto &vvc_map) -> size_t {
+    auto it = vvc_map.find(vvc);
+
+    if (it == vvc_map.end()) {
+      return 0;
+    }
+
+    size_t size_before = data.size();
+    int length = int(std::min<size_t>(max_bytes, std::numeric_limits<int>::max()));
+
+    pop_receive_bytes(it->first, it->second, length, false, data);
+
+    return data.size() - size_before;
+  });
+}
+
+bool
+UvvmCosimServer::RegQueueEmpty(std::string vvc_type,
+			       int vvc_instance_id)
+{
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = "NA",
+    .vvc_instance_id = vvc_instance_id
+  };
+
+  bool empty = vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it != vvc_map.end()) {
+      return it->second.reg_queue.empty();
+    } else {
+      std::cerr << "VVC with";
+      std::cerr << " type=" << vvc.vvc_type;
+      std::cerr << " channel=" << vvc.vvc_channel;
+      std::cerr << " instance_id=" << vvc.vvc_instance_id;
+      std::cerr << " does not exist." << std::endl;
+
+      return true; // empty
+    }
+  });
+
+  return empty;
+}
+
+std::optional<RegAccess>
+UvvmCosimServer::RegQueueGet(std::string vvc_type,
+			     int vvc_instance_id)
+{
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = "NA",
+    .vvc_instance_id = vvc_instance_id
+  };
+
+  std::optional<RegAccess> access;
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it == vvc_map.end()) {
+      std::cerr << "VVC with";
+      std::cerr << " type=" << vvc.vvc_type;
+      std::cerr << " channel=" << vvc.vvc_channel;
+      std::cerr << " instance_id=" << vvc.vvc_instance_id;
+      std::cerr << " does not exist." << std::endl;
+      return;
+    }
+
+    auto& queues = it->second;
+
+    if (queues.reg_queue.empty()) {
+      std::cerr << "RegQueueGet called on empty queue for VVC with";
+      std::cerr << " type=" << vvc.vvc_type;
+      std::cerr << " instance_id=" << vvc.vvc_instance_id;
+      std::cerr << std::endl;
+      return;
+    }
+
+    access = queues.reg_queue.front();
+    queues.reg_queue.pop_front();
+
+    // Reads complete in the order they are issued to the VVC
+    if (!access->write) {
+      queues.reg_read_pending.push_back(*access);
+    }
+  });
+
+  return access;
+}
+
+void
+UvvmCosimServer::RegReadResultPut(std::string vvc_type,
+				  int vvc_instance_id,
+				  uint64_t data)
+{
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = "NA",
+    .vvc_instance_id = vvc_instance_id
+  };
+
+  std::optional<RegAccess> read;
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it != vvc_map.end() && !it->second.reg_read_pending.empty()) {
+      read = it->second.reg_read_pending.front();
+      it->second.reg_read_pending.pop_front();
+    } else {
+      std::cerr << "Got register read result without pending read for VVC with";
+      std::cerr << " type=" << vvc.vvc_type;
+      std::cerr << " instance_id=" << vvc.vvc_instance_id;
+      std::cerr << std::endl;
+    }
+  });
+
+  if (read && read->batch) {
+    auto& batch = *read->batch;
+    {
+      std::lock_guard<std::mutex> lock(batch.mtx);
+      batch.data[read->batch_idx] = data;
+      batch.num_done++;
+    }
+    batch.cv.notify_all();
+  }
+}
+
+JsonResponse
+UvvmCosimServer::StartSim()
+{
+  startSim=true;
+
+  JsonResponse response = {
+    .success = false
+  };
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::GetVvcList()
+{
+  std::vector<VvcInstance> vec;
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    for (auto &vvc : vvc_map) {
+      vec.push_back(vvc.first);
+    }
+  });
+
+  JsonResponse response;
+  
+  response.success = true;
+  response.result = json(vec);
+
+  if (uartPtyBridge) {
+    for (auto &vvc : response.result) {
+      if (vvc["vvc_type"] == "UART_VVC") {
+	vvc["pty"] = uartPtyBridge->PtyPath(vvc["vvc_instance_id"]);
+      }
+    }
+  }
+
+  if (udpBridge) {
+    for (auto &vvc : response.result) {
+      if (vvc["vvc_type"] == "AXISTREAM_VVC") {
+	vvc["udp_rx_port"] = udpBridge->RxPort(vvc["vvc_instance_id"]);
+	vvc["udp_tx_port"] = udpBridge->TxPort(vvc["vvc_instance_id"]);
+	vvc["udp_oversized"] = udpBridge->NumOversized(vvc["vvc_instance_id"]);
+      }
+    }
+  }
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::TransmitBytes(std::string vvc_type, int vvc_id, std::vector<uint8_t> data)
+{
+  JsonResponse response;
+
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = (vvc_type == "UART_VVC" ? "TX" : "NA"),
+    .vvc_instance_id = vvc_id
+  };
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it != vvc_map.end()) {
+      queue_transmit_bytes(it->first, it->second, data.data(), data.size());
+
+      response.success = true;
+      response.result = json{};
+
+    } else {
+      std::string error_str = "VVC with";
+      error_str += " type=" + vvc.vvc_type;
+      error_str += " channel=" + vvc.vvc_channel;
+      error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
+      error_str += " does not exist.";
+      
+      response.success = false;
+      response.result = json{{"error", error_str}};
+    }
+  });
+
+  return response;
+}
+
+// The data is released to the transmit queue at the first simulation time
+// step at or after sim_time_ns (rounded up to the scheduler resolution), and
+// is then transmitted the same way as for TransmitBytes. Times that have
+// already passed release the data right away.
+JsonResponse
+UvvmCosimServer::TransmitBytesAt(std::string vvc_type, int vvc_id, double sim_time_ns, std::vector<uint8_t> data)
+{
+  JsonResponse response;
+
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = (vvc_type == "UART_VVC" ? "TX" : "NA"),
+    .vvc_instance_id = vvc_id
+  };
+
+  // Rejects negative, NaN and infinite times, and times too far away to
+  // be represented in scheduler ticks
+  double tick_f = std::ceil(sim_time_ns * 1e6 / C_SCHEDULER_TICK);
+
+  if (!(tick_f >= 0.0 && tick_f < std::ldexp(1.0, 64) / C_SCHEDULER_TICK)) {
+    response.success = false;
+    response.result = json{{"error", "Invalid sim_time_ns " + std::to_string(sim_time_ns)}};
+    return response;
+  }
+
+  uint64_t tick = tick_f;
+  uint64_t earliest = schedulerEarliest.load(std::memory_order_relaxed);
+
+  if (tick * C_SCHEDULER_TICK < earliest) {
+    response.success = false;
+    response.result = json{{"error", "sim_time_ns " + std::to_string(sim_time_ns)
+			    + " is in the past, simulation is at "
+			    + std::to_string((earliest - 1) / 1e6) + " ns"}};
+    return response;
+  }
+
+  bool vvc_exists = false;
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    vvc_exists = vvc_map.find(vvc) != vvc_map.end();
+  });
+
+  if (!vvc_exists) {
+    std::string error_str = "VVC with";
+    error_str += " type=" + vvc.vvc_type;
+    error_str += " channel=" + vvc.vvc_channel;
+    error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
+    error_str += " does not exist.";
+
+    response.success = false;
+    response.result = json{{"error", error_str}};
+    return response;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(schedulerMutex);
+
+    transmitScheduler.Schedule(tick, ScheduledTransmit{vvc, std::move(data)});
+    schedulerNextDue = transmitScheduler.NextDue() * C_SCHEDULER_TICK;
+  }
+
+  response.success = true;
+  response.result = json{{"sim_time_ns", tick * (C_SCHEDULER_TICK / 1e6)}};
+
+  return response;
+}
+
+// The file is memory mapped and read into the transmit queue in chunks as
+// the simulation consumes the data. A length of zero transmits everything
+// from offset to the end of the file.
+JsonResponse
+UvvmCosimServer::TransmitFile(std::string vvc_type, int vvc_id, std::string path, uint64_t offset, uint64_t length)
+{
+  JsonResponse response;
+
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = (vvc_type == "UART_VVC" ? "TX" : "NA"),
+    .vvc_instance_id = vvc_id
+  };
+
+  std::shared_ptr<MappedFile> file;
+
+  try {
+    file = std::make_shared<MappedFile>(path);
+  } catch (std::exception &e) {
+    response.success = false;
+    response.result = json{{"error", e.what()}};
+    return response;
+  }
+
+  if (offset > file->size() || length > file->size() - offset) {
+    response.success = false;
+    response.result = json{{"error", "Offset and length exceed size of " + path
+			    + " (" + std::to_string(file->size()) + " bytes)"}};
+    return response;
+  }
+
+  if (length == 0) {
+    length = file->size() - offset;
+  }
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it != vvc_map.end()) {
+      it->second.transmit_sources.push_back(std::make_unique<MappedFileSource>(file, offset, length));
+
+      response.success = true;
+      response.result = json{{"length", length}};
+
+    } else {
+      std::string error_str = "VVC with";
+      error_str += " type=" + vvc.vvc_type;
+      error_str += " channel=" + vvc.vvc_channel;
+      error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
+      error_str += " does not exist.";
+
+      response.success = false;
+      response.result = json{{"error", error_str}};
+    }
+  });
+
+  return response;
+}
+
+// Register an expected data source for a VVC. A negative max_mismatches
+// keeps the current limit on the number of mismatches reported.
+JsonResponse
+UvvmCosimServer::AddExpectSource(std::string vvc_type, int vvc_id, std::unique_ptr<DataSource> source,
+				 int max_mismatches)
+{
+  JsonResponse response;
+
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = (vvc_type == "UART_VVC" ? "RX" : "NA"),
+    .vvc_instance_id = vvc_id
+  };
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it != vvc_map.end()) {
+      auto& queues = it->second;
+
+      if (max_mismatches >= 0) {
+	queues.expect_status.max_mismatches = max_mismatches;
+      }
+
+      queues.expect_sources.push_back(std::move(source));
+
+      response.success = true;
+      response.result = json{{"receive_queue_empty", queues.receive_queue.empty() &&
+			      queues.receive_word_queue.empty()}};
+
+    } else {
+      std::string error_str = "VVC with";
+      error_str += " type=" + vvc.vvc_type;
+      error_str += " channel=" + vvc.vvc_channel;
+      error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
+      error_str += " does not exist.";
+
+      response.success = false;
+      response.result = json{{"error", error_str}};
+    }
+  });
+
+  return response;
+}
+
+// Data received after this call is compared against the expected data in
+// the server instead of being queued for ReceiveBytes/ReceivePacket.
+JsonResponse
+UvvmCosimServer::ExpectBytes(std::string vvc_type, int vvc_id, std::vector<uint8_t> data, int max_mismatches)
+{
+  auto source = std::make_unique<BytesSource>();
+  source->Append(data.data(), data.size());
+
+  return AddExpectSource(vvc_type, vvc_id, std::move(source), max_mismatches);
+}
+
+// Same as ExpectBytes, with the expected data read from a memory mapped file.
+// A length of zero expects everything from offset to the end of the file.
+JsonResponse
+UvvmCosimServer::ExpectFile(std::string vvc_type, int vvc_id, std::string path, uint64_t offset, uint64_t length,
+			    int max_mismatches)
+{
+  JsonResponse response;
+  std::shared_ptr<MappedFile> file;
+
+  try {
+    file = std::make_shared<MappedFile>(path);
+  } catch (std::exception &e) {
+    response.success = false;
+    response.result = json{{"error", e.what()}};
+    return response;
+  }
+
+  if (offset > file->size() || length > file->size() - offset) {
+    response.success = false;
+    response.result = json{{"error", "Offset and length exceed size of " + path
+			    + " (" + std::to_string(file->size()) + " bytes)"}};
+    return response;
+  }
+
+  if (length == 0) {
+    length = file->size() - offset;
+  }
+
+  response = AddExpectSource(vvc_type, vvc_id, std::make_unique<MappedFileSource>(file, offset, length),
+			     max_mismatches);
+
+  if (response.success) {
+    response.result["length"] = length;
+  }
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::GetExpectStatus(std::string vvc_type, int vvc_id, bool clear)
+{
+  JsonResponse response;
+
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = (vvc_type == "UART_VVC" ? "RX" : "NA"),
+    .vvc_instance_id = vvc_id
+  };
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it != vvc_map.end()) {
+      auto& queues = it->second;
+
+      response.success = true;
+      response.result = queues.expect_status;
+      response.result["done"] = queues.expect_sources.empty();
+
+      if (clear) {
+	size_t max_mismatches = queues.expect_status.max_mismatches;
+	queues.expect_status = ExpectStatus();
+	queues.expect_status.max_mismatches = max_mismatches;
+      }
+
+    } else {
+      std::string error_str = "VVC with";
+      error_str += " type=" + vvc.vvc_type;
+      error_str += " channel=" + vvc.vvc_channel;
+      error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
+      error_str += " does not exist.";
+
+      response.success = false;
+      response.result = json{{"error", error_str}};
+    }
+  });
+
+  return response;
+}
+
+// Create a generator source from StartGenerator/StartChecker parameters.
+// Returns nullptr and sets error if the parameters are not valid.
+static std::unique_ptr<GeneratorSource> make_generator_source(const std::string& kind, uint64_t seed, uint64_t length,
+							      uint64_t min_packet_length, uint64_t max_packet_length,
+							      std::string& error)
+{
+  auto pattern = GeneratorSource::ParsePattern(kind);
+
+  if (!pattern) {
+    error = "Unknown generator kind " + kind + " (should be prbs7, prbs15, prbs31 or counter)";
+    return nullptr;
+  }
+
+  if (max_packet_length > 0 && min_packet_length > max_packet_length) {
+    error = "min_packet_length is larger than max_packet_length";
+    return nullptr;
+  }
+
+  return std::make_unique<GeneratorSource>(pattern.value(), seed, length, min_packet_length, max_packet_length);
+}
+
+// The generated data is produced in chunks as the transmit queue drains,
+// so it can run for as long as the simulation does with a length of zero.
+// Data queued after a generator with no length is not transmitted until
+// the generator is stopped.
+JsonResponse
+UvvmCosimServer::StartGenerator(std::string vvc_type, int vvc_id, std::string kind, uint64_t seed, uint64_t length,
+				uint64_t min_packet_length, uint64_t max_packet_length)
+{
+  JsonResponse response;
+  std::string error_str;
+
+  auto source = make_generator_source(kind, seed, length, min_packet_length, max_packet_length, error_str);
+
+  if (!source) {
+    response.success = false;
+    response.result = json{{"error", error_str}};
+    return response;
+  }
+
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = (vvc_type == "UART_VVC" ? "TX" : "NA"),
+    .vvc_instance_id = vvc_id
+  };
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it != vvc_map.end()) {
+      it->second.transmit_sources.push_back(std::move(source));
+
+      response.success = true;
+      response.result = json{};
+
+    } else {
+      error_str = "VVC with";
+      error_str += " type=" + vvc.vvc_type;
+      error_str += " channel=" + vvc.vvc_channel;
+      error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
+      error_str += " does not exist.";
+
+      response.success = false;
+      response.result = json{{"error", error_str}};
+    }
+  });
+
+  return response;
+}
+
+// Check received data against a generated pattern, with the expect
+// mechanism (see ExpectBytes). Results are read with GetExpectStatus.
+JsonResponse
+UvvmCosimServer::StartChecker(std::string vvc_type, int vvc_id, std::string kind, uint64_t seed, uint64_t length,
+			      uint64_t min_packet_length, uint64_t max_packet_length, int max_mismatches)
+{
+  std::string error_str;
+
+  auto source = make_generator_source(kind, seed, length, min_packet_length, max_packet_length, error_str);
+
+  if (!source) {
+    JsonResponse response;
+    response.success = false;
+    response.result = json{{"error", error_str}};
+    return response;
+  }
+
+  return AddExpectSource(vvc_type, vvc_id, std::move(source), max_mismatches);
+}
+
+// Remove the generators from the transmit side and the checkers from the
+// receive side of a VVC. Generated data that has already been moved to the
+// transmit queue is still transmitted.
+JsonResponse
+UvvmCosimServer::StopGenerator(std::string vvc_type, int vvc_id)
+{
+  JsonResponse response;
+
+  VvcInstance tx_vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = (vvc_type == "UART_VVC" ? "TX" : "NA"),
+    .vvc_instance_id = vvc_id
+  };
+
+  VvcInstance rx_vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = (vvc_type == "UART_VVC" ? "RX" : "NA"),
+    .vvc_instance_id = vvc_id
+  };
+
+  auto is_generator = [](const std::unique_ptr<DataSource>& source) {
+    return dynamic_cast<GeneratorSource*>(source.get()) != nullptr;
+  };
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    auto tx_it = vvc_map.find(tx_vvc);
+    auto rx_it = vvc_map.find(rx_vvc);
+    uint64_t generated = 0;
+
+    if (tx_it != vvc_map.end()) {
+      auto& sources = tx_it->second.transmit_sources;
+
+      for (auto& source : sources) {
+	if (is_generator(source)) {
+	  generated += static_cast<GeneratorSource*>(source.get())->Generated();
+	}
+      }
+
+      std::erase_if(sources, is_generator);
+    }
+
+    if (rx_it != vvc_map.end()) {
+      std::erase_if(rx_it->second.expect_sources, is_generator);
+    }
+
+    if (tx_it != vvc_map.end() || rx_it != vvc_map.end()) {
+      response.success = true;
+      response.result = json{{"generated", generated}};
+
+    } else {
+      std::string error_str = "VVC with";
+      error_str += " type=" + vvc_type;
+      error_str += " instance_id=" + std::to_string(vvc_id);
+      error_str += " does not exist.";
+
+      response.success = false;
+      response.result = json{{"error", error_str}};
+    }
+  });
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::EnableTimestamps(std::string vvc_type, int vvc_id, bool enable)
+{
+  JsonResponse response;
+
+  // Both channels of UART VVCs
+  std::vector<VvcInstance> vvcs;
+
+  if (vvc_type == "UART_VVC") {
+    vvcs.push_back({.vvc_type = vvc_type, .vvc_channel = "TX", .vvc_instance_id = vvc_id});
+    vvcs.push_back({.vvc_type = vvc_type, .vvc_channel = "RX", .vvc_instance_id = vvc_id});
+  } else {
+    vvcs.push_back({.vvc_type = vvc_type, .vvc_channel = "NA", .vvc_instance_id = vvc_id});
+  }
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    bool found = false;
+
+    for (auto& vvc : vvcs) {
+      auto it = vvc_map.find(vvc);
+
+      if (it == vvc_map.end()) {
+	continue;
+      }
+
+      auto& queues = it->second;
+      found = true;
+
+      if (queues.timestamps_enabled == enable) {
+	continue;
+      }
+
+      if (enable) {
+	queues.receive_untimed = queues.receive_queue.size() +
+	  word_queue_bytes(queues.receive_word_queue, std::numeric_limits<size_t>::max());
+	numTimestampVvcs++;
+      } else {
+	queues.receive_timestamps.Clear();
+	queues.receive_untimed = 0;
+	queues.transmit_log.Clear();
+	queues.receive_log.Clear();
+	queues.latency_stats = {};
+	numTimestampVvcs--;
+      }
+
+      queues.timestamps_enabled = enable;
+    }
+
+    if (found) {
+      response.success = true;
+      response.result = json{};
+
+    } else {
+      std::string error_str = "VVC with";
+      error_str += " type=" + vvc_type;
+      error_str += " instance_id=" + std::to_string(vvc_id);
+      error_str += " does not exist.";
+
+      response.success = false;
+      response.result = json{{"error", error_str}};
+    }
+  });
+
+  return response;
+}
+
+// Correlate packets transmitted by one VVC with the data received by
+// another, by byte offset (the n-th byte transmitted is the n-th byte
+// received). The latency of a packet is from the simulation taking its
+// first byte for transmit until its last byte is received. Correlated
+// packets are popped from the logs, and their latencies added to stats.
+// Returns the number of transmitted packets not yet received.
+static uint64_t correlate_latency(TimestampLog& transmit_log, TimestampLog& receive_log, LatencyStats& stats)
+{
+  TimestampLog::Reader tx_reader(transmit_log);
+  TimestampLog::Reader rx_reader(receive_log);
+  TimestampLog::Chunk tx_chunk;
+  TimestampLog::Chunk rx_chunk = {};
+
+  uint64_t tx_offset = 0;     // Bytes read from transmit_log
+  uint64_t rx_offset = 0;     // Bytes read from receive_log
+  uint64_t correlated = 0;    // Bytes in the correlated packets
+  uint64_t pending = 0;
+  uint64_t packet_start = 0;
+  bool in_packet = false;
+
+  while (tx_reader.Next(tx_chunk)) {
+    if (!in_packet) {
+      packet_start = tx_chunk.time;
+      in_packet = true;
+    }
+
+    tx_offset += tx_chunk.num_bytes;
+
+    if (!tx_chunk.end_of_packet) {
+      continue;
+    }
+
+    in_packet = false;
+
+    while (rx_offset < tx_offset && rx_reader.Next(rx_chunk)) {
+      rx_offset += rx_chunk.num_bytes;
+    }
+
+    if (rx_offset < tx_offset) {
+      pending++;
+    } else {
+      stats.Add(rx_chunk.time > packet_start ? rx_chunk.time - packet_start : 0);
+      correlated = tx_offset;
+    }
+  }
+
+  transmit_log.PopFront(correlated);
+  receive_log.PopFront(correlated);
+
+  return pending;
+}
+
+JsonResponse
+UvvmCosimServer::GetLatencyStats(std::string tx_vvc_type, int tx_vvc_id, std::string rx_vvc_type, int rx_vvc_id,
+				 bool clear)
+{
+  JsonResponse response;
+
+  VvcInstance tx_vvc = {
+    .vvc_type = tx_vvc_type,
+    .vvc_channel = (tx_vvc_type == "UART_VVC" ? "TX" : "NA"),
+    .vvc_instance_id = tx_vvc_id
+  };
+
+  VvcInstance rx_vvc = {
+    .vvc_type = rx_vvc_type,
+    .vvc_channel = (rx_vvc_type == "UART_VVC" ? "RX" : "NA"),
+    .vvc_instance_id = rx_vvc_id
+  };
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    for (auto& vvc : {tx_vvc, rx_vvc}) {
+      auto it = vvc_map.find(vvc);
+      std::string error_str;
+
+      if (it == vvc_map.end()) {
+	error_str = "VVC with";
+	error_str += " type=" + vvc.vvc_type;
+	error_str += " channel=" + vvc.vvc_channel;
+	error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
+	error_str += " does not exist.";
+      } else if (!it->second.timestamps_enabled) {
+	error_str = "Timestamps are not enabled for VVC with";
+	error_str += " type=" + vvc.vvc_type;
+	error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
+      }
+
+      if (!error_str.empty()) {
+	response.success = false;
+	response.result = json{{"error", error_str}};
+	return;
+      }
+    }
+
+    auto& tx_queues = vvc_map.find(tx_vvc)->second;
+    auto& rx_queues = vvc_map.find(rx_vvc)->second;
+    uint64_t pending = correlate_latency(tx_queues.transmit_log, rx_queues.receive_log,
+					 tx_queues.latency_stats);
+
+    response.success = true;
+    response.result = tx_queues.latency_stats;
+    response.result["pending"] = pending;
+
+    if (clear) {
+      tx_queues.latency_stats = {};
+    }
+  });
+
+  return response;
+}
+
+void
+UvvmCosimServer::TransmitStageTimestamps(TransmitStageMap& stages, uint64_t sim_time)
+{
+  vvcInstanceMap([&](auto &vvc_map) {
+    for (auto& [key, stage] : stages) {
+      if (stage.dequeued.empty()) {
+	continue;
+      }
+
+      VvcInstance vvc = {
+	.vvc_type = key.first,
+	.vvc_channel = (key.first == "UART_VVC" ? "TX" : "NA"),
+	.vvc_instance_id = key.second
+      };
+
+      auto it = vvc_map.find(vvc);
+
+      if (it != vvc_map.end() && it->second.timestamps_enabled) {
+	for (auto& [num_bytes, end_of_packet] : stage.dequeued) {
+	  it->second.transmit_log.Append(sim_time, num_bytes, end_of_packet);
+	}
+      }
+
+      stage.dequeued.clear();
+    }
+  });
+}
+
+JsonResponse
+UvvmCosimServer::TransmitWords(std::string vvc_type, int vvc_id, std::vector<AxisWord> words)
+{
+  JsonResponse response;
+
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = "NA",
+    .vvc_instance_id = vvc_id
+  };
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it == vvc_map.end()) {
+      std::string error_str = "VVC with";
+      error_str += " type=" + vvc.vvc_type;
+      error_str += " channel=" + vvc.vvc_channel;
+      error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
+      error_str += " does not exist.";
+
+      response.success = false;
+      response.result = json{{"error", error_str}};
+      return;
+    }
+
+    size_t word_bytes = get_word_bytes(it->first);
+
+    if (word_bytes == 0) {
+      response.success = false;
+      response.result = json{{"error", "VVC type " + vvc.vvc_type + " does not support words"}};
+      return;
+    }
+
+    // Words can't be queued behind transmit sources without
+    // losing the sideband signals, so don't allow mixing them
+    if (!it->second.transmit_sources.empty()) {
+      response.success = false;
+      response.result = json{{"error", "Can't transmit words while TransmitFile is in progress"}};
+      return;
+    }
+
+    for (auto& word : words) {
+      if (word.num_bytes() > word_bytes) {
+	response.success = false;
+	response.result = json{{"error", "Word with " + std::to_string(word.num_bytes())
+				+ " bytes exceeds data width of " + std::to_string(word_bytes)
+				+ " bytes"}};
+	return;
+      }
+
+      // The VVC packs the bytes of a packet into bus words, so only the
+      // last word of a packet can have fewer bytes than the data width
+      if (word.num_bytes() < word_bytes && !word.tlast) {
+	response.success = false;
+	response.result = json{{"error", "Word with " + std::to_string(word.num_bytes())
+				+ " bytes is shorter than data width of " + std::to_string(word_bytes)
+				+ " bytes, but does not have tlast set"}};
+	return;
+      }
+    }
+
+    auto& q = it->second.transmit_word_queue;
+    q.insert(q.end(), words.begin(), words.end());
+
+    response.success = true;
+    response.result = json{};
+  });
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::ReceiveWords(std::string vvc_type, int vvc_id, int num_words, bool all_or_nothing)
+{
+  JsonResponse response;
+
+  if (num_words <= 0) {
+    response.success = false;
+    response.result = json{{"error", "Invalid num_words " + std::to_string(num_words)}};
+    return response;
+  }
+
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = "NA",
+    .vvc_instance_id = vvc_id
+  };
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it == vvc_map.end()) {
+      std::string error_str = "VVC with";
+      error_str += " type=" + vvc.vvc_type;
+      error_str += " channel=" + vvc.vvc_channel;
+      error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
+      error_str += " does not exist.";
+
+      response.success = false;
+      response.result = json{{"error", error_str}};
+      return;
+    }
+
+    std::vector<AxisWord> words;
+    auto& q = it->second.receive_word_queue;
+
+    if (!q.empty() && !(all_or_nothing && q.size() < size_t(num_words))) {
+      auto q_end = q.size() > size_t(num_words) ? q.begin()+num_words : q.end();
+
+      words.assign(q.begin(), q_end);
+      q.erase(q.begin(), q_end);
+    }
+
+    size_t num_bytes = 0;
+    for (auto& word : words) {
+      num_bytes += word.num_bytes();
+    }
+    pop_receive_timestamps(it->second, num_bytes, 0, nullptr);
+
+    response.success = true;
+    response.result = json{{"words", words}};
+  });
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::TransmitPacket(std::string vvc_type, int vvc_id, std::vector<uint8_t> data)
+{
+  JsonResponse response = {
+    .success = false,
+    .result = json{{"error", "Not implemented"}}
+  };
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::ReceiveBytes(std::string vvc_type, int vvc_id, int length, bool all_or_nothing)
+{
+  JsonResponse response;
+
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = (vvc_type == "UART_VVC" ? "RX" : "NA"),
+    .vvc_instance_id = vvc_id
+  };
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it != vvc_map.end()) {
+      std::vector<uint8_t> data;
+      std::vector<std::pair<size_t, uint64_t>> timestamps;
+      size_t available = pop_receive_bytes(it->first, it->second, length, all_or_nothing, data,
+					   &timestamps);
+
+      std::cout << "Server: " << "ReceiveBytes called with length=" << length;
+      std::cout << " and all_or_nothing=" << (all_or_nothing ? "true" : "false");
+
+      if (data.empty()) {
+	std::cout << ". Returning none, queue size = " << available << std::endl;
+      } else {
+	std::cout << ". Returning " << data.size() << " of " << available;
+	std::cout << " available bytes in queue" << std::endl;
+      }
+
+      response.success = true;
+      response.result = json{{"data", data}};
+
+      if (it->second.timestamps_enabled) {
+	response.result["timestamps"] = timestamps;
+      }
+
+    } else {
+      std::string error_str = "VVC with";
+      error_str += " type=" + vvc.vvc_type;
+      error_str += " channel=" + vvc.vvc_channel;
+      error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
+      error_str += " does not exist.";
+      
+      response.success = false;
+      response.result = json{{"error", error_str}};
+    }
+  });
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::ReceivePacket(std::string vvc_type, int vvc_id)
 {
   JsonResponse response = {
     .success = false,
@@ -340,3 +1827,213 @@ UvvmCosimServer::ReceivePacket(std::string vvc_type, int vvc_id)
 
   return response;
 }
+
+JsonResponse
+UvvmCosimServer::WriteRegs(std::string vvc_type, int vvc_id, std::vector<std::pair<uint64_t, uint64_t>> regs)
+{
+  JsonResponse response;
+
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = "NA",
+    .vvc_instance_id = vvc_id
+  };
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it != vvc_map.end()) {
+      auto& q = it->second.reg_queue;
+
+      for (auto& [addr, data] : regs) {
+	q.push_back(RegAccess{.write = true, .addr = addr, .data = data});
+      }
+
+      response.success = true;
+      response.result = json{};
+
+    } else {
+      std::string error_str = "VVC with";
+      error_str += " type=" + vvc.vvc_type;
+      error_str += " channel=" + vvc.vvc_channel;
+      error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
+      error_str += " does not exist.";
+
+      response.success = false;
+      response.result = json{{"error", error_str}};
+    }
+  });
+
+  return response;
+}
+
+// Unlike the other remote procedures, ReadRegs blocks until the simulation
+// has completed all the reads in the batch (or C_READ_REGS_TIMEOUT expires),
+// so that all read results can be returned in a single response.
+JsonResponse
+UvvmCosimServer::ReadRegs(std::string vvc_type, int vvc_id, std::vector<uint64_t> addr)
+{
+  JsonResponse response;
+
+  VvcInstance vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = "NA",
+    .vvc_instance_id = vvc_id
+  };
+
+  auto batch = std::make_shared<RegReadBatch>();
+  batch->data.resize(addr.size());
+
+  bool vvc_exists = vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it == vvc_map.end()) {
+      return false;
+    }
+
+    auto& q = it->second.reg_queue;
+
+    for (size_t i = 0; i < addr.size(); i++) {
+      q.push_back(RegAccess{.write = false, .addr = addr[i], .data = 0,
+			    .batch = batch, .batch_idx = i});
+    }
+
+    return true;
+  });
+
+  if (!vvc_exists) {
+    std::string error_str = "VVC with";
+    error_str += " type=" + vvc.vvc_type;
+    error_str += " channel=" + vvc.vvc_channel;
+    error_str += " instance_id=" + std::to_string(vvc.vvc_instance_id);
+    error_str += " does not exist.";
+
+    response.success = false;
+    response.result = json{{"error", error_str}};
+
+    return response;
+  }
+
+  std::unique_lock<std::mutex> lock(batch->mtx);
+
+  bool done = batch->cv.wait_for(lock, C_READ_REGS_TIMEOUT, [&]() {
+    return batch->num_done == batch->data.size();
+  });
+
+  if (!done) {
+    lock.unlock();
+
+    // Don't issue the remaining reads. Reads already issued to the VVC
+    // are kept in reg_read_pending, since results are matched to them in
+    // order, but their results are dropped.
+    vvcInstanceMap([&](auto &vvc_map) {
+      auto it = vvc_map.find(vvc);
+
+      if (it != vvc_map.end()) {
+	std::erase_if(it->second.reg_queue, [&](const RegAccess& access) {
+	  return access.batch == batch;
+	});
+
+	for (auto& access : it->second.reg_read_pending) {
+	  if (access.batch == batch) {
+	    access.batch.reset();
+	  }
+	}
+      }
+    });
+
+    lock.lock();
+    done = (batch->num_done == batch->data.size());
+  }
+
+  if (done) {
+    response.success = true;
+    response.result = json{{"data", batch->data}};
+  } else {
+    response.success = false;
+    response.result = json{{"error", "Timeout waiting for " + std::to_string(batch->data.size() - batch->num_done)
+			    + " of " + std::to_string(batch->data.size()) + " register reads"}};
+  }
+
+  return response;
+}
+
+bool
+UvvmCosimServer::HandleFastPath(const std::string &request, std::string &response)
+{
+  // Reused between requests handled by the same server thread
+  thread_local std::vector<uint8_t> data;
+
+  if (data.capacity() > C_FAST_PATH_MAX_BUFFER) {
+    data = std::vector<uint8_t>();
+  }
+  data.clear();
+
+  FastPathRequest req(data);
+
+  if (!json::sax_parse(request, &req) || !req.Valid()) {
+    return false;
+  }
+
+  bool transmit = req.method == "TransmitBytes";
+
+  VvcInstance vvc = {
+    .vvc_type = req.vvc_type,
+    .vvc_channel = (req.vvc_type == "UART_VVC" ? (transmit ? "TX" : "RX") : "NA"),
+    .vvc_instance_id = int(req.vvc_id)
+  };
+
+  bool handled = false;
+
+  vvcInstanceMap([&](auto &vvc_map) {
+    auto it = vvc_map.find(vvc);
+
+    if (it != vvc_map.end()) {
+      // Timestamps are only included in responses from the normal path
+      if (!transmit && it->second.timestamps_enabled) {
+	return;
+      }
+
+      handled = true;
+
+      if (transmit) {
+	queue_transmit_bytes(it->first, it->second, data.data(), data.size());
+	data.clear();
+      } else {
+	pop_receive_bytes(it->first, it->second, req.length, req.all_or_nothing, data);
+      }
+    }
+  });
+
+  // Let the normal path respond (with an error, or with timestamps)
+  if (!handled) {
+    return false;
+  }
+
+  // Same response as the JSON-RPC server gives for the normal path
+  response.reserve(64 + 4*data.size());
+  response += "{\"id\":";
+  response += req.id.dump();
+  response += ",\"jsonrpc\":\"2.0\",\"result\":{\"result\":";
+
+  if (transmit) {
+    response += "null";
+  } else {
+    response += "{\"data\":[";
+
+    char buf[4];
+    for (size_t i = 0; i < data.size(); i++) {
+      if (i > 0) {
+	response += ',';
+      }
+      auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), data[i]);
+      response.append(buf, end);
+    }
+
+    response += "]}";
+  }
+
+  response += ",\"success\":true}}";
+
+  return true;
+}
@@ -1,20 +1,45 @@
 #pragma once
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <utility>
 #include <vector>
 #include <jsonrpccxx/server.hpp>
-#include <cpphttplibconnector.hpp>
 #include "uvvm_cosim_types.hpp"
 #include "shared_map.hpp"
+#include "timing_wheel.hpp"
+#include "uart_pty_bridge.hpp"
+#include "udp_bridge.hpp"
+#include "uvvm_cosim_server_connector.hpp"
+
+// Optional server features
+struct ServerOptions {
+  // Create a pty for each UART VVC (see UartPtyBridge)
+  bool uart_pty = false;
+
+  // Base port for connecting AXI-Stream VVCs to UDP sockets, 0 to
+  // disable (see UdpBridge)
+  int udp_base_port = 0;
+
+  // Suspend the simulation when there has been no cosim activity for this
+  // many milliseconds (wall clock), 0 to disable (see SuspendIfIdle)
+  int idle_suspend_ms = 0;
+
+  // Responses of at least this many bytes are compressed, when the client
+  // accepts it, 0 to disable (see http_compression.hpp)
+  size_t compress_threshold = C_COMPRESS_THRESHOLD;
+};
 
 class UvvmCosimServer {
 private:
 
   jsonrpccxx::JsonRpc2Server jsonRpcServer;
-  CppHttpLibServerConnector httpServer;
+  UvvmCosimServerConnector httpServer;
 
   // Key type: VvcInstance
   // Value type: VvcQueues
@@ -23,6 +48,58 @@ private:
 
   std::atomic<bool> startSim=false;
 
+  std::unique_ptr<UartPtyBridge> uartPtyBridge;
+  std::unique_ptr<UdpBridge> udpBridge;
+
+  // Transmits scheduled with TransmitBytesAt, in scheduler ticks
+  std::mutex schedulerMutex;
+  TimingWheel<ScheduledTransmit> transmitScheduler;
+
+  // Simulation time of the earliest scheduled transmit. Checked by the
+  // simulation every time step without taking the scheduler lock.
+  std::atomic<uint64_t> schedulerNextDue = TimingWheel<ScheduledTransmit>::C_NEVER;
+
+  // Earliest simulation time that has not been passed yet (the time step
+  // after the last one the simulation has completed)
+  std::atomic<uint64_t> schedulerEarliest = 0;
+
+  // Idle suspension. lastActivity is the steady clock time (ns) of the
+  // last request or bridge/receive activity, and activityCount is
+  // incremented on every activity to wake up a suspended simulation.
+  std::chrono::nanoseconds idleSuspendWindow{0};
+  std::atomic<int64_t> lastActivity = 0;
+  std::atomic<uint64_t> activityCount = 0;
+  std::atomic<bool> idleSuspended = false;
+  std::mutex idleMutex;
+  std::condition_variable idleCv;
+
+  // Check that all transmit, register and expect queues are empty
+  bool QueuesIdle();
+
+  // Number of VVCs with timestamps enabled (see EnableTimestamps)
+  std::atomic<int> numTimestampVvcs = 0;
+
+  // Put bytes received by a VVC in its receive queue, unless they are
+  // compared against expected data or passed on to a pty
+  void PutReceivedBytes(const VvcInstance& vvc, VvcQueues& queues, const uint8_t* data,
+			const uint8_t* end_of_packet, size_t length, uint64_t sim_time);
+
+  // Put a word received by a VVC in its receive queue, unless it is
+  // compared against expected data or passed on to a UDP socket
+  void PutReceivedWord(const VvcInstance& vvc, VvcQueues& queues, const AxisWord& word,
+		       uint64_t sim_time);
+
+  // Queue bytes written to the pty of a UART VVC for transmission
+  void UartPtyTransmit(int vvc_instance_id, const uint8_t* data, size_t length);
+
+  // Queue a datagram received on the UDP socket of an AXI-Stream VVC
+  // for transmission as one packet
+  void UdpTransmit(int vvc_instance_id, const uint8_t* data, size_t length);
+
+  // Handle TransmitBytes and ReceiveBytes requests without building json
+  // objects for the data. Returns false if the request was not handled.
+  bool HandleFastPath(const std::string &request, std::string &response);
+
   // --------------------------------------------------------------------------
   // JSON-RPC remote procedures
   // --------------------------------------------------------------------------
@@ -32,17 +109,65 @@ private:
 
   JsonResponse TransmitBytes(std::string vvc_type, int vvc_id, std::vector<uint8_t> data);
   JsonResponse TransmitPacket(std::string vvc_type, int vvc_id, std::vector<uint8_t> data);
+  JsonResponse TransmitBytesAt(std::string vvc_type, int vvc_id, double sim_time_ns, std::vector<uint8_t> data);
 
   JsonResponse ReceiveBytes(std::string vvc_type, int vvc_id, int length, bool all_or_nothing);
   JsonResponse ReceivePacket(std::string vvc_type, int vvc_id);
 
+  JsonResponse AddExpectSource(std::string vvc_type, int vvc_id, std::unique_ptr<DataSource> source,
+			       int max_mismatches);
+
+  JsonResponse TransmitFile(std::string vvc_type, int vvc_id, std::string path, uint64_t offset, uint64_t length);
+
+  JsonResponse ExpectBytes(std::string vvc_type, int vvc_id, std::vector<uint8_t> data, int max_mismatches);
+  JsonResponse ExpectFile(std::string vvc_type, int vvc_id, std::string path, uint64_t offset, uint64_t length, int max_mismatches);
+  JsonResponse GetExpectStatus(std::string vvc_type, int vvc_id, bool clear);
+
+  JsonResponse StartGenerator(std::string vvc_type, int vvc_id, std::string kind, uint64_t seed, uint64_t length,
+			      uint64_t min_packet_length, uint64_t max_packet_length);
+  JsonResponse StartChecker(std::string vvc_type, int vvc_id, std::string kind, uint64_t seed, uint64_t length,
+			    uint64_t min_packet_length, uint64_t max_packet_length, int max_mismatches);
+  JsonResponse StopGenerator(std::string vvc_type, int vvc_id);
+
+  JsonResponse EnableTimestamps(std::string vvc_type, int vvc_id, bool enable);
+  JsonResponse GetLatencyStats(std::string tx_vvc_type, int tx_vvc_id, std::string rx_vvc_type, int rx_vvc_id,
+			       bool clear);
+
+  JsonResponse TransmitWords(std::string vvc_type, int vvc_id, std::vector<AxisWord> words);
+  JsonResponse ReceiveWords(std::string vvc_type, int vvc_id, int num_words, bool all_or_nothing);
+
+  JsonResponse WriteRegs(std::string vvc_type, int vvc_id, std::vector<std::pair<uint64_t, uint64_t>> regs);
+  JsonResponse ReadRegs(std::string vvc_type, int vvc_id, std::vector<uint64_t> addr);
+
 public:
-  UvvmCosimServer(int port)
+  UvvmCosimServer(int port, ServerOptions options = {})
     : jsonRpcServer()
-    , httpServer(jsonRpcServer, port)
+    , httpServer(jsonRpcServer, port,
+		 [this](const std::string &request, std::string &response) {
+		   NoteActivity();
+		   return HandleFastPath(request, response);
+		 },
+		 options.compress_threshold)
   {
     using namespace jsonrpccxx;
 
+    idleSuspendWindow = std::chrono::milliseconds(options.idle_suspend_ms);
+    NoteActivity();
+
+    if (options.uart_pty) {
+      uartPtyBridge = std::make_unique<UartPtyBridge>(
+	[this](int vvc_instance_id, const uint8_t* data, size_t length) {
+	  UartPtyTransmit(vvc_instance_id, data, length);
+	});
+    }
+
+    if (options.udp_base_port > 0) {
+      udpBridge = std::make_unique<UdpBridge>(options.udp_base_port,
+	[this](int vvc_instance_id, const uint8_t* data, size_t length) {
+	  UdpTransmit(vvc_instance_id, data, length);
+	});
+    }
+
     // Add JSON-RPC procedures
 
     jsonRpcServer.Add("TransmitBytes",
@@ -53,6 +178,10 @@ public:
                       GetHandle(&UvvmCosimServer::TransmitPacket, *this),
                       {"vvc_type", "vvc_id", "data"});
 
+    jsonRpcServer.Add("TransmitBytesAt",
+                      GetHandle(&UvvmCosimServer::TransmitBytesAt, *this),
+                      {"vvc_type", "vvc_id", "sim_time_ns", "data"});
+
     jsonRpcServer.Add("ReceiveBytes",
                       GetHandle(&UvvmCosimServer::ReceiveBytes, *this),
                       {"vvc_type", "vvc_id", "length", "all_or_nothing"});
@@ -61,6 +190,59 @@ public:
                       GetHandle(&UvvmCosimServer::ReceivePacket, *this),
                       {"vvc_type", "vvc_id", "length", "all_or_nothing"});
 
+    jsonRpcServer.Add("TransmitFile",
+                      GetHandle(&UvvmCosimServer::TransmitFile, *this),
+                      {"vvc_type", "vvc_id", "path", "offset", "length"});
+
+    jsonRpcServer.Add("ExpectBytes",
+                      GetHandle(&UvvmCosimServer::ExpectBytes, *this),
+                      {"vvc_type", "vvc_id", "data", "max_mismatches"});
+
+    jsonRpcServer.Add("ExpectFile",
+                      GetHandle(&UvvmCosimServer::ExpectFile, *this),
+                      {"vvc_type", "vvc_id", "path", "offset", "length", "max_mismatches"});
+
+    jsonRpcServer.Add("GetExpectStatus",
+                      GetHandle(&UvvmCosimServer::GetExpectStatus, *this),
+                      {"vvc_type", "vvc_id", "clear"});
+
+    jsonRpcServer.Add("StartGenerator",
+                      GetHandle(&UvvmCosimServer::StartGenerator, *this),
+                      {"vvc_type", "vvc_id", "kind", "seed", "length", "min_packet_length", "max_packet_length"});
+
+    jsonRpcServer.Add("StartChecker",
+                      GetHandle(&UvvmCosimServer::StartChecker, *this),
+                      {"vvc_type", "vvc_id", "kind", "seed", "length", "min_packet_length", "max_packet_length",
+		       "max_mismatches"});
+
+    jsonRpcServer.Add("StopGenerator",
+                      GetHandle(&UvvmCosimServer::StopGenerator, *this),
+                      {"vvc_type", "vvc_id"});
+
+    jsonRpcServer.Add("EnableTimestamps",
+                      GetHandle(&UvvmCosimServer::EnableTimestamps, *this),
+                      {"vvc_type", "vvc_id", "enable"});
+
+    jsonRpcServer.Add("GetLatencyStats",
+                      GetHandle(&UvvmCosimServer::GetLatencyStats, *this),
+                      {"tx_vvc_type", "tx_vvc_id", "rx_vvc_type", "rx_vvc_id", "clear"});
+
+    jsonRpcServer.Add("TransmitWords",
+                      GetHandle(&UvvmCosimServer::TransmitWords, *this),
+                      {"vvc_type", "vvc_id", "words"});
+
+    jsonRpcServer.Add("ReceiveWords",
+                      GetHandle(&UvvmCosimServer::ReceiveWords, *this),
+                      {"vvc_type", "vvc_id", "num_words", "all_or_nothing"});
+
+    jsonRpcServer.Add("WriteRegs",
+                      GetHandle(&UvvmCosimServer::WriteRegs, *this),
+                      {"vvc_type", "vvc_id", "regs"});
+
+    jsonRpcServer.Add("ReadRegs",
+                      GetHandle(&UvvmCosimServer::ReadRegs, *this),
+                      {"vvc_type", "vvc_id", "addr"});
+
     jsonRpcServer.Add("GetVvcList",
                       GetHandle(&UvvmCosimServer::GetVvcList, *this), {});
 
@@ -89,14 +271,83 @@ public:
 
   void WaitForStartSim();
 
+  // is_master is the direction of the VVC, when it is known from the
+  // design hierarchy. It is added to the VVC config as is_master.
   void AddVvc(std::string vvc_type, std::string vvc_channel,
-	      int vvc_instance_id, std::string vvc_cfg_str);
+	      int vvc_instance_id, std::string vvc_cfg_str,
+	      std::optional<bool> is_master = std::nullopt);
 
   bool TransmitQueueEmpty(std::string vvc_type, int vvc_instance_id);
 
-  std::optional<std::pair<uint8_t, bool>> TransmitQueueGet(std::string vvc_type, int vvc_instance_id);
+  // Publish the data staged by the simulation during a time step to the
+  // VVC receive queues, with one lock for all VVCs. The stages are emptied.
+  void ReceiveStagePut(ReceiveStageMap& stages, uint64_t sim_time);
+
+  // Move up to max_bytes of data from the transmit queue of a VVC to a
+  // stage in the simulation, with one lock
+  void TransmitStageFetch(std::string vvc_type, int vvc_instance_id, TransmitStage& stage, size_t max_bytes);
+
+  // True when timestamps are enabled for any VVC
+  bool TimestampsEnabled() const
+  {
+    return numTimestampVvcs > 0;
+  }
+
+  // Add the bytes taken by the simulation from the transmit stages during
+  // a time step to the transmit timestamp logs of VVCs with timestamps
+  // enabled, with one lock for all VVCs. The dequeued runs are cleared.
+  void TransmitStageTimestamps(TransmitStageMap& stages, uint64_t sim_time);
+
+  // Check that a VVC exists (on either channel for UART VVCs)
+  bool HasVvc(std::string vvc_type, int vvc_instance_id);
+
+  // Check if the data received by a VVC is sent on as packets by a bridge
+  // (UDP), so each receive transaction must end a packet
+  bool IsPacketBridged(std::string vvc_type, int vvc_instance_id);
+
+  // Queue bytes for transmit, as TransmitBytes/TransmitPacket but without
+  // going through JSON-RPC (used by plugins). Returns false if the VVC
+  // does not exist.
+  bool TransmitQueuePut(std::string vvc_type, int vvc_instance_id, const uint8_t* data, size_t length,
+			bool end_of_packet);
+
+  // Pop up to max_bytes from the receive queue of a VVC and append them to
+  // data, as ReceiveBytes but without going through JSON-RPC (used by
+  // plugins). Returns the number of bytes popped.
+  size_t ReceiveQueueGet(std::string vvc_type, int vvc_instance_id, size_t max_bytes,
+			 std::vector<uint8_t>& data);
+
+  bool RegQueueEmpty(std::string vvc_type, int vvc_instance_id);
+
+  std::optional<RegAccess> RegQueueGet(std::string vvc_type, int vvc_instance_id);
+
+  void RegReadResultPut(std::string vvc_type, int vvc_instance_id, uint64_t data);
+
+  // Release scheduled transmits that are due at sim_time to the VVC queues
+  void AdvanceScheduler(uint64_t sim_time);
+
+  // Simulation time of the earliest scheduled transmit, or
+  // TimingWheel::C_NEVER when nothing is scheduled
+  uint64_t SchedulerNextDue() const
+  {
+    return schedulerNextDue;
+  }
+
+  bool IdleSuspendEnabled() const
+  {
+    return idleSuspendWindow.count() > 0;
+  }
+
+  // Record cosim activity (requests, bridge and received data). Wakes up
+  // the simulation if it is suspended in SuspendIfIdle.
+  void NoteActivity();
 
-  void ReceiveQueuePut(std::string vvc_type, int vvc_instance_id, uint8_t byte, bool end_of_packet=false);
+  // Block the simulation thread until the next activity, when there has
+  // been no activity for the idle suspend window and there is no pending
+  // transmit data, scheduled transmit, register access, or expected data.
+  // Called by the simulation at the end of a time step, once the
+  // simulation side stages are empty.
+  void SuspendIfIdle();
 
 };
   
@@ -0,0 +1,126 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <jsonrpccxx/server.hpp>
+#include <cpphttplibconnector.hpp>
+#include "http_compression.hpp"
+
+// HTTP server connector for the JSON-RPC server. Same as the
+// CppHttpLibServerConnector from the json-rpc-cxx examples, except that
+// requests are first offered to a fast path handler. The fast path handles
+// the bulk data methods without going through a json object tree, and
+// returns false for requests it does not handle, which are then passed on
+// to the JSON-RPC server as normal.
+//
+// Requests may be compressed (see http_compression.hpp), and responses of
+// at least compress_threshold bytes are compressed when the client accepts
+// it (0 disables compression of responses).
+class UvvmCosimServerConnector {
+public:
+  using FastPathHandler = std::function<bool(const std::string &request, std::string &response)>;
+
+  UvvmCosimServerConnector(jsonrpccxx::JsonRpcServer &server, int port, FastPathHandler fast_path,
+			   size_t compress_threshold = C_COMPRESS_THRESHOLD)
+    : thread()
+    , server(server)
+    , fastPath(std::move(fast_path))
+    , httpServer()
+    , port(port)
+    , compressThreshold(compress_threshold)
+  {
+    httpServer.Post("/jsonrpc",
+		    [this](const httplib::Request &req, httplib::Response &res) {
+		      this->PostAction(req, res);
+		    });
+  }
+
+  virtual ~UvvmCosimServerConnector()
+  {
+    StopListening();
+  }
+
+  bool StartListening()
+  {
+    if (httpServer.is_running()) {
+      return false;
+    }
+
+    this->thread = std::thread([this]() { this->httpServer.listen("localhost", port); });
+    return true;
+  }
+
+  void StopListening()
+  {
+    if (httpServer.is_running()) {
+      httpServer.stop();
+      this->thread.join();
+    }
+  }
+
+private:
+  std::thread thread;
+  jsonrpccxx::JsonRpcServer &server;
+  FastPathHandler fastPath;
+  httplib::Server httpServer;
+  int port;
+  size_t compressThreshold;
+
+  void PostAction(const httplib::Request &req, httplib::Response &res)
+  {
+    std::string supported = supported_content_codings();
+
+    // Lets clients know which codings they can use for requests
+    if (!supported.empty()) {
+      res.set_header("Accept-Encoding", supported);
+    }
+
+    // httplib has already decoded gzip requests when built with zlib
+    // support, in which case the body no longer starts with the magic number
+    auto request_coding = parse_content_coding(req.get_header_value("Content-Encoding"));
+    const std::string* request = &req.body;
+    std::string decoded;
+
+    if (!request_coding) {
+      res.status = 415; // Unsupported Media Type
+      return;
+    }
+
+    if (has_content_coding_magic(*request_coding, req.body)) {
+      if (!decompress_content(*request_coding, req.body, decoded)) {
+	res.status = 400;
+	return;
+      }
+      request = &decoded;
+    }
+
+    std::string response;
+
+    if (!fastPath || !fastPath(*request, response)) {
+      response = this->server.HandleRequest(*request);
+    }
+
+    if (compressThreshold > 0 && response.size() >= compressThreshold) {
+      auto coding = negotiate_content_coding(req.get_header_value("Accept-Encoding"));
+      std::string compressed;
+
+      if (coding != ContentCoding::IDENTITY && compress_content(coding, response, compressed)) {
+	response.swap(compressed);
+	res.set_header("Content-Encoding", content_coding_name(coding));
+      }
+    }
+
+    res.status = 200;
+
+    // Set with a content provider of known length, because httplib (when
+    // built with zlib support) compresses content set with set_content by
+    // itself, regardless of size and of the Content-Encoding set above
+    auto content = std::make_shared<std::string>(std::move(response));
+
+    res.set_content_provider(content->size(), "application/json",
+			     [content](size_t offset, size_t length, httplib::DataSink &sink) {
+			       return sink.write(content->data() + offset, length);
+			     });
+  }
+};
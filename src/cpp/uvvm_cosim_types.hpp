@@ -1,18 +1,144 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 #include "nlohmann/json.hpp"
+#include "data_source.hpp"
+#include "timestamp_log.hpp"
 
 // Todo: Use namespace
 //namespace uvvm_cosim {
 
 using json = nlohmann::json;
 
+// Max width of data words in word based queues (512-bit tdata)
+constexpr size_t C_MAX_WORD_BYTES = 64;
+
+// Data word with sideband signals, used in the word based queues for
+// AXI-Stream VVCs. Valid bytes in tdata are indicated by tkeep (one bit
+// per byte), and only the last bytes in a word can be invalid.
+struct AxisWord {
+  std::array<uint8_t, C_MAX_WORD_BYTES> tdata = {};
+  uint64_t tkeep = 0;
+  uint32_t tuser = 0;
+  uint32_t tid = 0;
+  uint32_t tdest = 0;
+  bool tlast = false;
+
+  size_t num_bytes() const { return std::popcount(tkeep); }
+};
+
+// tkeep value for a word with num_bytes valid bytes
+inline uint64_t tkeep_mask(size_t num_bytes)
+{
+  return num_bytes >= 64 ? ~uint64_t(0) : (uint64_t(1) << num_bytes) - 1;
+}
+
+// Results for a batch of register reads issued by one ReadRegs call.
+// Filled in by the simulator thread as the reads complete, while the
+// RPC thread waits on the condition variable.
+struct RegReadBatch {
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::vector<uint64_t> data;
+  size_t num_done = 0;
+};
+
+// Register access for memory-mapped VVCs (AXI-Lite).
+// Reads keep a pointer to the batch (and index in it) they belong to. The
+// pointer is null for reads whose batch has timed out.
+struct RegAccess {
+  bool write;
+  uint64_t addr;
+  uint64_t data;
+  std::shared_ptr<RegReadBatch> batch;
+  size_t batch_idx;
+};
+
+// Received byte that did not match the expected data
+struct ExpectMismatch {
+  uint64_t offset;    // Offset in expected data stream
+  uint8_t expected;
+  uint8_t received;
+  uint64_t sim_time;  // Simulation time when byte was received
+};
+
+// Result of comparing received data against expected data for a VVC
+struct ExpectStatus {
+  uint64_t num_compared = 0;
+  uint64_t num_mismatches = 0;
+  size_t max_mismatches = 16; // Max number of mismatches to keep details of
+  std::vector<ExpectMismatch> mismatches;
+};
+
+// Packet latencies measured by GetLatencyStats, in simulation time (fs).
+// Bucket i of the histogram counts latencies of [2^i, 2^(i+1)) ns, and
+// bucket 0 also counts latencies below 1 ns.
+struct LatencyStats {
+  uint64_t count = 0;
+  uint64_t min = UINT64_MAX;
+  uint64_t max = 0;
+  double sum = 0.0;
+  std::array<uint64_t, 64> buckets = {};
+
+  void Add(uint64_t latency)
+  {
+    uint64_t latency_ns = latency / 1000000;
+
+    count++;
+    min = std::min(min, latency);
+    max = std::max(max, latency);
+    sum += latency;
+    buckets[latency_ns == 0 ? 0 : std::bit_width(latency_ns) - 1]++;
+  }
+};
+
 // Note: Many VVCs will only use one of the queues
 struct VvcQueues {
   std::deque<std::pair<uint8_t, bool>> transmit_queue;
   std::deque<std::pair<uint8_t, bool>> receive_queue;
+
+  // Word based queues, used instead of the byte queues by
+  // VVCs that report a data_width in their config (AXI-Stream)
+  std::deque<AxisWord> transmit_word_queue;
+  std::deque<AxisWord> receive_word_queue;
+
+  // Sources that are read into the transmit queue (byte or word based)
+  // in chunks as the simulation consumes data from it (e.g. files)
+  std::deque<std::unique_ptr<DataSource>> transmit_sources;
+
+  // Expected receive data. While there is expected data pending, received
+  // data is compared against it and dropped instead of being queued.
+  std::deque<std::unique_ptr<DataSource>> expect_sources;
+  ExpectStatus expect_status;
+
+  // Register accesses not yet issued to the VVC,
+  // and reads issued to the VVC that are waiting for a result
+  std::deque<RegAccess> reg_queue;
+  std::deque<RegAccess> reg_read_pending;
+
+  // Simulation time stamps, only recorded when enabled with
+  // EnableTimestamps. receive_timestamps follows the bytes in the receive
+  // queue (except the first receive_untimed bytes, which were queued before
+  // timestamps were enabled). transmit_log and receive_log have all bytes
+  // taken by the simulation for transmit and received by the VVC, and are
+  // consumed by GetLatencyStats, which adds the latencies to latency_stats.
+  bool timestamps_enabled = false;
+  TimestampLog receive_timestamps;
+  uint64_t receive_untimed = 0;
+  TimestampLog transmit_log;
+  TimestampLog receive_log;
+  LatencyStats latency_stats;
 };
 
 struct VvcInstance {
@@ -22,6 +148,53 @@ struct VvcInstance {
   std::map<std::string, int> vvc_cfg;
 };
 
+// Data staged by the simulation thread, which is published to or fetched
+// from the VVC queues in bulk, so the VVC queue lock is taken at most once
+// per simulation time step instead of for every byte or word.
+struct ReceiveStage {
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> end_of_packet; // One flag per byte in data
+  std::vector<AxisWord> words;
+
+  bool empty() const { return data.empty() && words.empty(); }
+};
+
+struct TransmitStage {
+  std::deque<std::pair<uint8_t, bool>> bytes;
+  std::deque<AxisWord> words;
+  uint64_t fetch_time = UINT64_MAX; // Simulation time of the last fetch
+
+  // The last word taken did not have tlast set, so the rest of the packet
+  // may be fetched again in the same time step
+  bool packet_open = false;
+
+  // Bytes taken by the simulation during the time step, in runs that end
+  // with the end of packet flag of the last byte. Only recorded when
+  // timestamps are enabled.
+  std::vector<std::pair<size_t, bool>> dequeued;
+
+  void Dequeued(size_t num_bytes, bool end_of_packet)
+  {
+    if (dequeued.empty() || dequeued.back().second) {
+      dequeued.emplace_back(0, false);
+    }
+    dequeued.back().first += num_bytes;
+    dequeued.back().second = end_of_packet;
+  }
+
+  bool empty() const { return bytes.empty() && words.empty(); }
+};
+
+// Key: VVC type and instance ID
+using ReceiveStageMap = std::map<std::pair<std::string, int>, ReceiveStage>;
+using TransmitStageMap = std::map<std::pair<std::string, int>, TransmitStage>;
+
+// Data scheduled for transmission at a simulation time
+struct ScheduledTransmit {
+  VvcInstance vvc;
+  std::vector<uint8_t> data;
+};
+
 // This class should implement the necessary comparator function (with
 // strict ordering) so we can use VvcInstance with std::map.
 // https://stackoverflow.com/questions/6573225/what-requirements-must-stdmap-key-classes-meet-to-be-valid-keys
@@ -53,6 +226,65 @@ inline void from_json(const json &j, VvcInstance &v) {
   j.at("vvc_cfg").get_to(v.vvc_cfg);
 }
 
+// Only the valid bytes of tdata (according to tkeep) are included in
+// "data". When converting from JSON, tkeep is derived from the length
+// of "data", and the sideband fields are optional.
+inline void to_json(json &j, const AxisWord &w) {
+  j = json{{"data", std::vector<uint8_t>(w.tdata.begin(), w.tdata.begin()+w.num_bytes())},
+           {"tkeep", w.tkeep},
+           {"tuser", w.tuser},
+           {"tid", w.tid},
+           {"tdest", w.tdest},
+           {"tlast", w.tlast}};
+}
+
+inline void from_json(const json &j, AxisWord &w) {
+  auto data = j.at("data").get<std::vector<uint8_t>>();
+
+  if (data.size() > C_MAX_WORD_BYTES) {
+    throw std::invalid_argument("Word with " + std::to_string(data.size()) + " bytes exceeds max word size");
+  }
+
+  std::copy(data.begin(), data.end(), w.tdata.begin());
+  w.tkeep = tkeep_mask(data.size());
+  w.tuser = j.value("tuser", 0);
+  w.tid = j.value("tid", 0);
+  w.tdest = j.value("tdest", 0);
+  w.tlast = j.value("tlast", false);
+}
+
+inline void to_json(json &j, const ExpectMismatch &m) {
+  j = json{{"offset", m.offset},
+           {"expected", m.expected},
+           {"received", m.received},
+           {"sim_time", m.sim_time}};
+}
+
+inline void to_json(json &j, const ExpectStatus &s) {
+  j = json{{"num_compared", s.num_compared},
+           {"num_mismatches", s.num_mismatches},
+           {"mismatches", s.mismatches}};
+}
+
+// Times in ns. Only the non-empty buckets of the histogram are included.
+inline void to_json(json &j, const LatencyStats &s) {
+  json histogram = json::array();
+
+  for (size_t i = 0; i < s.buckets.size(); i++) {
+    if (s.buckets[i] > 0) {
+      histogram.push_back(json{{"min_ns", i == 0 ? 0 : uint64_t(1) << i},
+                               {"max_ns", uint64_t(1) << (i+1)},
+                               {"count", s.buckets[i]}});
+    }
+  }
+
+  j = json{{"count", s.count},
+           {"min_ns", s.count > 0 ? s.min / 1e6 : 0.0},
+           {"max_ns", s.max / 1e6},
+           {"mean_ns", s.count > 0 ? s.sum / s.count / 1e6 : 0.0},
+           {"histogram", histogram}};
+}
+
 struct JsonResponse {
   bool success;
   json result;
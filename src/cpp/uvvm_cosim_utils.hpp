@@ -1,9 +1,14 @@
 #pragma once
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 #include <cstring>
+#include <strings.h>
 #include <vhpi_user.h>
 
+// Max number of elements in std_logic_vector parameters passed via VHPI
+constexpr size_t C_MAX_LOGIC_VEC_SIZE = 1024;
+
 inline std::string get_vhpi_cb_string_param_by_index(const vhpiCbDataT* p_cb_data, int param_index)
 {
   // String buffer size is pretty large to accomodate
@@ -49,6 +54,112 @@ inline int get_vhpi_cb_int_param_by_index(const vhpiCbDataT* p_cb_data, int para
   return vhpi_val.value.intg;
 }
 
+// Get a std_logic_vector parameter as a little-endian byte array, so that
+// the rightmost element of the vector ends up in bit 0 of buf[0].
+// Elements that are not '1' or 'H' are read as zero.
+// Returns the number of elements in the vector.
+inline size_t get_vhpi_cb_logic_vec_param_by_index(const vhpiCbDataT* p_cb_data, int param_index,
+						    uint8_t* buf, size_t buf_size)
+{
+  vhpiHandleT h_param = vhpi_handle_by_index(vhpiParamDecls,
+					     p_cb_data->obj,
+					     param_index);
+  vhpiEnumT vec_buff[C_MAX_LOGIC_VEC_SIZE];
+  vhpiValueT vhpi_val = {.format = vhpiLogicVecVal};
+  vhpi_val.bufSize = sizeof(vec_buff);
+  vhpi_val.value.enumvs = vec_buff;
+
+  if (vhpi_get_value(h_param, &vhpi_val) != 0) {
+    vhpi_printf("Failed to get param index %d as logic vector", param_index);
+    throw std::runtime_error(std::string("VHPI error: Failed to get parameter index ")
+			     + std::to_string(param_index)
+			     + std::string(" as logic vector"));
+  }
+
+  size_t num_elems = vhpi_val.numElems;
+
+  std::memset(buf, 0, buf_size);
+
+  for (size_t bit = 0; bit < num_elems && bit/8 < buf_size; bit++) {
+    vhpiEnumT val = vec_buff[num_elems-1-bit];
+
+    if (val == vhpi1 || val == vhpiH) {
+      buf[bit/8] |= 1 << (bit%8);
+    }
+  }
+
+  return num_elems;
+}
+
+inline uint64_t get_vhpi_cb_logic_vec_param_as_uint64(const vhpiCbDataT* p_cb_data, int param_index)
+{
+  uint8_t buf[sizeof(uint64_t)];
+  uint64_t value = 0;
+
+  get_vhpi_cb_logic_vec_param_by_index(p_cb_data, param_index, buf, sizeof(buf));
+
+  for (size_t i = 0; i < sizeof(buf); i++) {
+    value |= uint64_t(buf[i]) << (8*i);
+  }
+
+  return value;
+}
+
+// Set a std_logic_vector (out) parameter from a little-endian byte array.
+// Vector elements beyond buf_size are set to '0'.
+inline void set_vhpi_cb_logic_vec_param_by_index(const vhpiCbDataT* p_cb_data, int param_index,
+						  const uint8_t* buf, size_t buf_size)
+{
+  vhpiHandleT h_param = vhpi_handle_by_index(vhpiParamDecls,
+					     p_cb_data->obj,
+					     param_index);
+  vhpiEnumT vec_buff[C_MAX_LOGIC_VEC_SIZE];
+  vhpiValueT vhpi_val = {.format = vhpiLogicVecVal};
+  vhpi_val.bufSize = sizeof(vec_buff);
+  vhpi_val.value.enumvs = vec_buff;
+
+  // Read current value first to find the size of the vector
+  if (vhpi_get_value(h_param, &vhpi_val) != 0) {
+    vhpi_printf("Failed to get param index %d as logic vector", param_index);
+    throw std::runtime_error(std::string("VHPI error: Failed to get parameter index ")
+			     + std::to_string(param_index)
+			     + std::string(" as logic vector"));
+  }
+
+  size_t num_elems = vhpi_val.numElems;
+
+  for (size_t bit = 0; bit < num_elems; bit++) {
+    bool one = bit/8 < buf_size && (buf[bit/8] >> (bit%8)) & 1;
+    vec_buff[num_elems-1-bit] = one ? vhpi1 : vhpi0;
+  }
+
+  vhpi_put_value(h_param, &vhpi_val, vhpiDeposit);
+}
+
+inline void set_vhpi_cb_logic_vec_param_from_uint64(const vhpiCbDataT* p_cb_data, int param_index,
+						     uint64_t value)
+{
+  uint8_t buf[sizeof(uint64_t)];
+
+  for (size_t i = 0; i < sizeof(buf); i++) {
+    buf[i] = (value >> (8*i)) & 0xFF;
+  }
+
+  set_vhpi_cb_logic_vec_param_by_index(p_cb_data, param_index, buf, sizeof(buf));
+}
+
+inline void set_vhpi_cb_int_param_by_index(const vhpiCbDataT* p_cb_data, int param_index, int value)
+{
+  vhpiHandleT h_param = vhpi_handle_by_index(vhpiParamDecls,
+					     p_cb_data->obj,
+					     param_index);
+  vhpiValueT vhpi_val = {
+    .format = vhpiIntVal,
+    .value = { .intg = value }
+  };
+  vhpi_put_value(h_param, &vhpi_val, vhpiDeposit);
+}
+
 inline void set_vhpi_int_retval(const vhpiCbDataT* p_cb_data, int value)
 {
   vhpiValueT ret_val = {
@@ -58,6 +169,57 @@ inline void set_vhpi_int_retval(const vhpiCbDataT* p_cb_data, int value)
   vhpi_put_value(p_cb_data->obj, &ret_val, vhpiDeposit);
 }
 
+// Current simulation time in the time unit of the simulator (normally fs)
+inline uint64_t get_vhpi_sim_time()
+{
+  vhpiTimeT t;
+  vhpi_get_time(&t, NULL);
+
+  return (uint64_t(t.high) << 32) | t.low;
+}
+
+// Case insensitive compare of VHDL identifiers (simulators differ in
+// whether names are returned in upper or lower case)
+inline bool vhdl_name_equal(const char* a, const char* b)
+{
+  return a != nullptr && b != nullptr && strcasecmp(a, b) == 0;
+}
+
+// Get the value of a generic of a design instance as an integer. Works for
+// integer and enumeration (e.g. boolean) generics. Returns false if the
+// instance has no generic with that name, or it has another type.
+inline bool get_vhpi_generic_int(vhpiHandleT h_inst, const char* generic_name, int64_t& value)
+{
+  vhpiHandleT h_iter = vhpi_iterator(vhpiGenericDecls, h_inst);
+  bool found = false;
+
+  if (h_iter == NULL) {
+    return false;
+  }
+
+  while (vhpiHandleT h_generic = vhpi_scan(h_iter)) {
+    if (!found && vhdl_name_equal(reinterpret_cast<const char*>(vhpi_get_str(vhpiNameP, h_generic)), generic_name)) {
+      vhpiValueT vhpi_val = {.format = vhpiObjTypeVal};
+
+      if (vhpi_get_value(h_generic, &vhpi_val) == 0) {
+	found = true;
+
+	switch (vhpi_val.format) {
+	case vhpiEnumVal:      value = vhpi_val.value.enumv;      break;
+	case vhpiSmallEnumVal: value = vhpi_val.value.smallenumv; break;
+	case vhpiIntVal:       value = vhpi_val.value.intg;       break;
+	case vhpiLongIntVal:   value = vhpi_val.value.longintg;   break;
+	default:               found = false;                     break;
+	}
+      }
+    }
+
+    vhpi_release_handle(h_generic);
+  }
+
+  return found;
+}
+
 inline void check_foreignf_registration(const vhpiHandleT& h, const char* func_name, vhpiForeignKindT kind)
 {
   vhpiForeignDataT check;
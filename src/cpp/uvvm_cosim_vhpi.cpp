@@ -1,11 +1,16 @@
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <deque>
 #include <exception>
+#include <map>
+#include <memory>
 #include <optional>
 #include <string>
 #include <thread>
 #include <vector>
 #include <vhpi_user.h>
+#include "plugin_runtime.hpp"
 #include "uvvm_cosim_utils.hpp"
 #include "uvvm_cosim_server.hpp"
 #include "uvvm_cosim_types.hpp"
@@ -16,6 +21,8 @@ extern "C" {
 // SERVER FUNCTIONS
 // ----------------------------------------------------------------------------
 
+constexpr int C_DEFAULT_PORT = 8484;
+
 // TODO: Use shared or unique pointer?
 static UvvmCosimServer* cosim_server;
 
@@ -25,7 +32,32 @@ void start_rpc_server(void)
   // Use a foreign function and call after UVVM init instead?
   // Then we can set port in a generic in VHDL code
 
-  cosim_server = new UvvmCosimServer(8484);
+  int port = C_DEFAULT_PORT;
+
+  // Allows several simulations on the same host (e.g. behind uvvm_cosim_hub)
+  if (const char* port_str = std::getenv("UVVM_COSIM_PORT")) {
+    port = std::atoi(port_str);
+  }
+
+  ServerOptions options;
+
+  if (const char* uart_pty_str = std::getenv("UVVM_COSIM_UART_PTY")) {
+    options.uart_pty = std::atoi(uart_pty_str) != 0;
+  }
+
+  if (const char* udp_port_str = std::getenv("UVVM_COSIM_UDP_BASE_PORT")) {
+    options.udp_base_port = std::atoi(udp_port_str);
+  }
+
+  if (const char* idle_str = std::getenv("UVVM_COSIM_IDLE_SUSPEND_MS")) {
+    options.idle_suspend_ms = std::atoi(idle_str);
+  }
+
+  if (const char* threshold_str = std::getenv("UVVM_COSIM_COMPRESS_THRESHOLD")) {
+    options.compress_threshold = std::strtoull(threshold_str, nullptr, 10);
+  }
+
+  cosim_server = new UvvmCosimServer(port, options);
 
   std::cout << "Start JSON RPC server" << std::endl;
   cosim_server->StartListening();
@@ -39,17 +71,197 @@ void stop_rpc_server(void)
 }
 
 
+// ----------------------------------------------------------------------------
+// STAGING BUFFERS
+// ----------------------------------------------------------------------------
+
+// Max number of bytes fetched from a VVC transmit queue at a time
+constexpr size_t C_TRANSMIT_PREFETCH = 4096;
+
+// Data received by the VVCs is staged here during a time step, and
+// published to the VVC receive queues in the server at the end of the
+// time step. Transmit data is fetched from the VVC transmit queues in bulk,
+// once per VVC per time step, or again while the simulation is in the
+// middle of a packet, so a packet longer than the prefetch is not split
+// in several VVC commands. This keeps the simulation thread from taking
+// the VVC queue lock (and contending with the RPC threads) for every byte.
+// Only accessed from the simulation thread.
+static ReceiveStageMap receive_stages;
+static bool receive_staged = false;
+static TransmitStageMap transmit_stages;
+static bool transmit_dequeued = false; // Dequeued runs recorded for timestamps
+static bool transmit_taken = false;    // Data taken from a stage in this time step
+
+static TransmitStage& get_transmit_stage(const std::string& vvc_type, int vvc_instance_id)
+{
+  auto& stage = transmit_stages[{vvc_type, vvc_instance_id}];
+
+  if (stage.empty()) {
+    uint64_t now = get_vhpi_sim_time();
+
+    if (stage.fetch_time != now || stage.packet_open) {
+      cosim_server->TransmitStageFetch(vvc_type, vvc_instance_id, stage, C_TRANSMIT_PREFETCH);
+      stage.fetch_time = now;
+
+      // Only fetch again in this time step if there was more of the packet
+      stage.packet_open = stage.packet_open && !stage.empty();
+    }
+  }
+
+  return stage;
+}
+
+static void flush_receive_stages(void)
+{
+  if (receive_staged) {
+    cosim_server->ReceiveStagePut(receive_stages, get_vhpi_sim_time());
+    receive_staged = false;
+  }
+}
+
+// Record bytes taken from a transmit stage for idle suspension and the
+// transmit timestamps
+static void note_transmit_dequeued(TransmitStage& stage, size_t num_bytes, bool end_of_packet)
+{
+  transmit_taken = true;
+
+  if (cosim_server->TimestampsEnabled()) {
+    stage.Dequeued(num_bytes, end_of_packet);
+    transmit_dequeued = true;
+  }
+}
+
+static void flush_transmit_dequeued(void)
+{
+  if (transmit_dequeued) {
+    cosim_server->TransmitStageTimestamps(transmit_stages, get_vhpi_sim_time());
+    transmit_dequeued = false;
+  }
+}
+
+static bool transmit_stages_empty(void)
+{
+  return std::all_of(transmit_stages.begin(), transmit_stages.end(),
+		     [](const auto& entry) { return entry.second.empty(); });
+}
+
+
+// ----------------------------------------------------------------------------
+// PLUGIN
+// ----------------------------------------------------------------------------
+
+// In-process test sequencer plugin, loaded from UVVM_COSIM_PLUGIN
+static std::unique_ptr<PluginRuntime> plugin_runtime;
+
+static void load_plugin(void)
+{
+  const char* plugin_path = std::getenv("UVVM_COSIM_PLUGIN");
+
+  if (plugin_path == nullptr || *plugin_path == '\0') {
+    return;
+  }
+
+  auto runtime = std::make_unique<PluginRuntime>(*cosim_server,
+    [](const std::string& vvc_type, int vvc_instance_id) {
+      auto it = transmit_stages.find({vvc_type, vvc_instance_id});
+      return it == transmit_stages.end() || it->second.empty();
+    });
+
+  if (runtime->Load(plugin_path)) {
+    plugin_runtime = std::move(runtime);
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+// DESIGN HIERARCHY
+// ----------------------------------------------------------------------------
+
+// Direction (GC_VVC_IS_MASTER) of the axistream_vvc instances in the design.
+// Key: GC_INSTANCE_IDX
+static std::map<int, bool> axistream_vvc_is_master;
+
+// Search the design hierarchy below a region for axistream_vvc instances,
+// since the direction of the VVC is only available as a generic
+static void find_axistream_vvcs(vhpiHandleT h_region)
+{
+  vhpiHandleT h_iter = vhpi_iterator(vhpiInternalRegions, h_region);
+
+  if (h_iter == NULL) {
+    return;
+  }
+
+  while (vhpiHandleT h_sub = vhpi_scan(h_iter)) {
+    const char* entity_name = reinterpret_cast<const char*>(vhpi_get_str(vhpiEntityNameP, h_sub));
+    int64_t is_master;
+    int64_t instance_idx;
+
+    if (vhdl_name_equal(entity_name, "axistream_vvc") &&
+	get_vhpi_generic_int(h_sub, "GC_VVC_IS_MASTER", is_master) &&
+	get_vhpi_generic_int(h_sub, "GC_INSTANCE_IDX", instance_idx)) {
+
+      vhpi_printf("Found AXISTREAM VVC %d (%s) at %s", int(instance_idx),
+		  is_master ? "master" : "slave",
+		  reinterpret_cast<const char*>(vhpi_get_str(vhpiFullNameP, h_sub)));
+
+      axistream_vvc_is_master.emplace(int(instance_idx), is_master != 0);
+    } else {
+      find_axistream_vvcs(h_sub);
+    }
+
+    vhpi_release_handle(h_sub);
+  }
+}
+
+static std::optional<bool> get_vvc_is_master(const std::string& vvc_type, int vvc_instance_id)
+{
+  if (vvc_type == "AXISTREAM_VVC") {
+    if (auto it = axistream_vvc_is_master.find(vvc_instance_id); it != axistream_vvc_is_master.end()) {
+      return it->second;
+    }
+  }
+
+  return std::nullopt;
+}
+
+
 // ----------------------------------------------------------------------------
 // VHPI foreign functions, procedures, and callbacks
 // ----------------------------------------------------------------------------
 
+//int vhpi_cosim_vvc_is_master(const char* vvc_type, int vvc_instance_id)
+// Returns 1 for master (transmit) VVCs, 0 for slave (receive) VVCs, and -1
+// if the direction is not known
+void vhpi_cosim_vvc_is_master(const vhpiCbDataT* p_cb_data)
+{
+  std::string vvc_type = get_vhpi_cb_string_param_by_index(p_cb_data, 0);
+  int vvc_instance_id = get_vhpi_cb_int_param_by_index(p_cb_data, 1);
+
+  auto is_master = get_vvc_is_master(vvc_type, vvc_instance_id);
+
+  set_vhpi_int_retval(p_cb_data, is_master ? (is_master.value() ? 1 : 0) : -1);
+}
+
+//int vhpi_cosim_vvc_packet_bridged(const char* vvc_type, int vvc_instance_id)
+// Returns 1 if each receive transaction of the VVC must end a packet,
+// because received data is sent on as packets by a bridge
+void vhpi_cosim_vvc_packet_bridged(const vhpiCbDataT* p_cb_data)
+{
+  std::string vvc_type = get_vhpi_cb_string_param_by_index(p_cb_data, 0);
+  int vvc_instance_id = get_vhpi_cb_int_param_by_index(p_cb_data, 1);
+
+  bool bridged = cosim_server->IsPacketBridged(vvc_type, vvc_instance_id);
+
+  set_vhpi_int_retval(p_cb_data, bridged ? 1 : 0);
+}
+
 //int vhpi_cosim_transmit_queue_empty(const char* vvc_type, int vvc_instance_id)
 void vhpi_cosim_transmit_queue_empty(const vhpiCbDataT* p_cb_data)
 {
   std::string vvc_type = get_vhpi_cb_string_param_by_index(p_cb_data, 0);
   int vvc_instance_id = get_vhpi_cb_int_param_by_index(p_cb_data, 1);
 
-  bool empty = cosim_server->TransmitQueueEmpty(vvc_type, vvc_instance_id);
+  bool empty = get_transmit_stage(vvc_type, vvc_instance_id).empty();
 
   set_vhpi_int_retval(p_cb_data, empty ? 1 : 0);
 }
@@ -60,17 +272,19 @@ void vhpi_cosim_transmit_queue_get(const vhpiCbDataT* p_cb_data)
   std::string vvc_type = get_vhpi_cb_string_param_by_index(p_cb_data, 0);
   int vvc_instance_id = get_vhpi_cb_int_param_by_index(p_cb_data, 1);
 
-  auto byte = cosim_server->TransmitQueueGet(vvc_type, vvc_instance_id);
+  auto& stage = get_transmit_stage(vvc_type, vvc_instance_id);
 
-  if (byte) {
-    int data = byte.value().first;
-    data |= byte.value().second << 9;
+  if (!stage.bytes.empty()) {
+    int data = stage.bytes.front().first;
+    data |= stage.bytes.front().second << 9;
+    note_transmit_dequeued(stage, 1, stage.bytes.front().second);
+    stage.bytes.pop_front();
     
     set_vhpi_int_retval(p_cb_data, data);
   } else {
-    // TODO:
-    // Kill simulation if TransmitQueueGet didn't return anything?
-    set_vhpi_int_retval(p_cb_data, 0); // Return zero for now
+    vhpi_assert(vhpiError, "vhpi_cosim_transmit_queue_get called on empty queue for VVC with type=%s instance_id=%d",
+		vvc_type.c_str(), vvc_instance_id);
+    set_vhpi_int_retval(p_cb_data, 0);
   }
 }
 
@@ -82,16 +296,128 @@ void vhpi_cosim_receive_queue_put(const vhpiCbDataT* p_cb_data)
   uint8_t byte = get_vhpi_cb_int_param_by_index(p_cb_data, 2);
   bool end_of_packet = get_vhpi_cb_int_param_by_index(p_cb_data, 3) == 1 ? true : false;
 
-  cosim_server->ReceiveQueuePut(vvc_type, vvc_instance_id, byte, end_of_packet);
+  auto& stage = receive_stages[{vvc_type, vvc_instance_id}];
+  stage.data.push_back(byte);
+  stage.end_of_packet.push_back(end_of_packet);
+  receive_staged = true;
+}
+
+//void vhpi_cosim_transmit_word_get(const char* vvc_type, int vvc_instance_id,
+//                                  slv* tdata, slv* tkeep, slv* tuser, slv* tid, slv* tdest,
+//                                  int* tlast)
+void vhpi_cosim_transmit_word_get(const vhpiCbDataT* p_cb_data)
+{
+  std::string vvc_type = get_vhpi_cb_string_param_by_index(p_cb_data, 0);
+  int vvc_instance_id = get_vhpi_cb_int_param_by_index(p_cb_data, 1);
+
+  auto& stage = get_transmit_stage(vvc_type, vvc_instance_id);
+
+  // An empty word (tkeep all zeros) is returned if there was none to get
+  AxisWord word = {};
+
+  if (!stage.words.empty()) {
+    word = stage.words.front();
+    stage.words.pop_front();
+    stage.packet_open = !word.tlast;
+    note_transmit_dequeued(stage, word.num_bytes(), word.tlast);
+  } else {
+    vhpi_assert(vhpiError, "vhpi_cosim_transmit_word_get called on empty queue for VVC with type=%s instance_id=%d",
+		vvc_type.c_str(), vvc_instance_id);
+  }
+
+  set_vhpi_cb_logic_vec_param_by_index(p_cb_data, 2, word.tdata.data(), word.tdata.size());
+  set_vhpi_cb_logic_vec_param_from_uint64(p_cb_data, 3, word.tkeep);
+  set_vhpi_cb_logic_vec_param_from_uint64(p_cb_data, 4, word.tuser);
+  set_vhpi_cb_logic_vec_param_from_uint64(p_cb_data, 5, word.tid);
+  set_vhpi_cb_logic_vec_param_from_uint64(p_cb_data, 6, word.tdest);
+  set_vhpi_cb_int_param_by_index(p_cb_data, 7, word.tlast ? 1 : 0);
+}
+
+//void vhpi_cosim_receive_word_put(const char* vvc_type, int vvc_instance_id,
+//                                 slv tdata, slv tkeep, slv tuser, slv tid, slv tdest,
+//                                 int tlast)
+void vhpi_cosim_receive_word_put(const vhpiCbDataT* p_cb_data)
+{
+  std::string vvc_type = get_vhpi_cb_string_param_by_index(p_cb_data, 0);
+  int vvc_instance_id = get_vhpi_cb_int_param_by_index(p_cb_data, 1);
+
+  AxisWord word;
+  get_vhpi_cb_logic_vec_param_by_index(p_cb_data, 2, word.tdata.data(), word.tdata.size());
+  word.tkeep = get_vhpi_cb_logic_vec_param_as_uint64(p_cb_data, 3);
+  word.tuser = get_vhpi_cb_logic_vec_param_as_uint64(p_cb_data, 4);
+  word.tid = get_vhpi_cb_logic_vec_param_as_uint64(p_cb_data, 5);
+  word.tdest = get_vhpi_cb_logic_vec_param_as_uint64(p_cb_data, 6);
+  word.tlast = get_vhpi_cb_int_param_by_index(p_cb_data, 7) == 1 ? true : false;
+
+  receive_stages[{vvc_type, vvc_instance_id}].words.push_back(word);
+  receive_staged = true;
+}
+
+//int vhpi_cosim_reg_queue_empty(const char* vvc_type, int vvc_instance_id)
+void vhpi_cosim_reg_queue_empty(const vhpiCbDataT* p_cb_data)
+{
+  std::string vvc_type = get_vhpi_cb_string_param_by_index(p_cb_data, 0);
+  int vvc_instance_id = get_vhpi_cb_int_param_by_index(p_cb_data, 1);
+
+  bool empty = cosim_server->RegQueueEmpty(vvc_type, vvc_instance_id);
+
+  set_vhpi_int_retval(p_cb_data, empty ? 1 : 0);
+}
+
+//void vhpi_cosim_reg_queue_get(const char* vvc_type, int vvc_instance_id,
+//                              int* is_write, slv* addr, slv* data)
+void vhpi_cosim_reg_queue_get(const vhpiCbDataT* p_cb_data)
+{
+  std::string vvc_type = get_vhpi_cb_string_param_by_index(p_cb_data, 0);
+  int vvc_instance_id = get_vhpi_cb_int_param_by_index(p_cb_data, 1);
+
+  auto access = cosim_server->RegQueueGet(vvc_type, vvc_instance_id);
+
+  if (access) {
+    set_vhpi_cb_int_param_by_index(p_cb_data, 2, access.value().write ? 1 : 0);
+    set_vhpi_cb_logic_vec_param_from_uint64(p_cb_data, 3, access.value().addr);
+    set_vhpi_cb_logic_vec_param_from_uint64(p_cb_data, 4, access.value().data);
+  } else {
+    // Return is_write=-1 (no access). Only a warning, since the reads
+    // of a timed out ReadRegs are removed from the queue by the RPC thread,
+    // and may be gone since the controller found the queue non-empty.
+    vhpi_assert(vhpiWarning, "vhpi_cosim_reg_queue_get called on empty queue for VVC with type=%s instance_id=%d",
+		vvc_type.c_str(), vvc_instance_id);
+    set_vhpi_cb_int_param_by_index(p_cb_data, 2, -1);
+  }
+}
+
+//void vhpi_cosim_reg_read_result_put(const char* vvc_type, int vvc_instance_id, slv data)
+void vhpi_cosim_reg_read_result_put(const vhpiCbDataT* p_cb_data)
+{
+  std::string vvc_type = get_vhpi_cb_string_param_by_index(p_cb_data, 0);
+  int vvc_instance_id = get_vhpi_cb_int_param_by_index(p_cb_data, 1);
+  uint64_t data = get_vhpi_cb_logic_vec_param_as_uint64(p_cb_data, 2);
+
+  cosim_server->RegReadResultPut(vvc_type, vvc_instance_id, data);
 }
 
 void vhpi_cosim_start_sim(const vhpiCbDataT* p_cb_data)
 {
+  // A plugin drives the simulation itself, don't wait for a client
+  if (plugin_runtime) {
+    vhpi_printf("vhpi_cosim_start_sim: Plugin loaded, starting sim");
+    return;
+  }
+
   vhpi_printf("vhpi_cosim_start_sim: Waiting to start sim");
   cosim_server->WaitForStartSim();
   vhpi_printf("vhpi_cosim_start_sim: Starting sim");
 }
 
+// Called by the testbench when all VVCs have been reported
+void vhpi_cosim_init_done(const vhpiCbDataT* p_cb_data)
+{
+  if (plugin_runtime) {
+    plugin_runtime->Start(get_vhpi_sim_time());
+  }
+}
+
 void vhpi_cosim_report_vvc_info(const vhpiCbDataT* p_cb_data)
 {
   std::string vvc_type = get_vhpi_cb_string_param_by_index(p_cb_data, 0);
@@ -106,7 +432,8 @@ void vhpi_cosim_report_vvc_info(const vhpiCbDataT* p_cb_data)
 	      vvc_instance_id,
 	      vvc_cfg_str.c_str());
 
-  cosim_server->AddVvc(vvc_type, vvc_channel, vvc_instance_id, vvc_cfg_str);
+  cosim_server->AddVvc(vvc_type, vvc_channel, vvc_instance_id, vvc_cfg_str,
+		       get_vvc_is_master(vvc_type, vvc_instance_id));
 }
 
 long convert_time_to_ns(const vhpiTimeT *time)
@@ -114,9 +441,101 @@ long convert_time_to_ns(const vhpiTimeT *time)
   return (((long)time->high << 32) | (long)time->low) / 1000000;
 }
 
+// Simulation time of the earliest wakeup registered for the transmit
+// scheduler and plugin time waits
+static uint64_t scheduler_wakeup = TimingWheel<ScheduledTransmit>::C_NEVER;
+
+void scheduler_wakeup_cb(const vhpiCbDataT * cb_data) {
+  uint64_t now = get_vhpi_sim_time();
+
+  if (now >= scheduler_wakeup) {
+    scheduler_wakeup = TimingWheel<ScheduledTransmit>::C_NEVER;
+  }
+
+  cosim_server->AdvanceScheduler(now);
+
+  if (plugin_runtime) {
+    plugin_runtime->Poll(now);
+  }
+}
+
+// Called at the end of every time step. Publishes the data received during
+// the time step, and the transmit timestamps, to the server. Releases
+// scheduled transmits that are due and resumes plugin tasks that are
+// ready, and registers a wakeup for the next time wait so it is handled on
+// time even if nothing else happens in the simulation at that time.
+// Suspends the simulation when idle suspension is enabled and there has
+// been no cosim activity.
+void end_of_time_step_cb(const vhpiCbDataT * cb_data) {
+  uint64_t now = get_vhpi_sim_time();
+  bool received = receive_staged;
+  bool transmitted = transmit_taken;
+
+  transmit_taken = false;
+
+  flush_receive_stages();
+  flush_transmit_dequeued();
+
+  cosim_server->AdvanceScheduler(now);
+
+  uint64_t next_due = cosim_server->SchedulerNextDue();
+
+  if (plugin_runtime) {
+    plugin_runtime->Poll(now);
+    next_due = std::min(next_due, plugin_runtime->NextDue());
+  }
+
+  if (next_due > now && next_due < scheduler_wakeup) {
+    vhpiCbDataT wakeup_cb_data;
+    vhpiTimeT delay = {
+      .high = uint32_t((next_due - now) >> 32),
+      .low = uint32_t(next_due - now)
+    };
+
+    wakeup_cb_data.reason = vhpiCbAfterDelay;
+    wakeup_cb_data.cb_rtn = scheduler_wakeup_cb;
+    wakeup_cb_data.obj = NULL;
+    wakeup_cb_data.time = &delay;
+    wakeup_cb_data.value = NULL;
+    wakeup_cb_data.user_data = NULL;
+
+    vhpi_register_cb(&wakeup_cb_data, 0);
+    scheduler_wakeup = next_due;
+  }
+
+  // A plugin drives the simulation itself, so it is never idle
+  if (cosim_server->IdleSuspendEnabled() && !plugin_runtime) {
+    // Data taken for transmit counts as activity, so the VVC commands
+    // it was put in get the idle window to complete
+    if (received || transmitted) {
+      cosim_server->NoteActivity();
+    } else if (transmit_stages_empty()) {
+      cosim_server->SuspendIfIdle();
+    }
+  }
+}
+
 void start_of_sim_cb(const vhpiCbDataT * cb_data) {
   vhpi_printf("Start of simulation");
+
+  if (vhpiHandleT h_root = vhpi_handle(vhpiRootInst, NULL)) {
+    find_axistream_vvcs(h_root);
+    vhpi_release_handle(h_root);
+  }
+
   start_rpc_server();
+  load_plugin();
+
+  vhpiCbDataT time_step_cb_data;
+
+  time_step_cb_data.reason = vhpiCbRepEndOfTimeStep;
+  time_step_cb_data.cb_rtn = end_of_time_step_cb;
+  time_step_cb_data.obj = NULL;
+  time_step_cb_data.time = NULL;
+  time_step_cb_data.value = NULL;
+  time_step_cb_data.user_data = NULL;
+
+  vhpi_register_cb(&time_step_cb_data, 0);
 }
 
 void end_of_sim_cb(const vhpiCbDataT * cb_data) {
@@ -126,6 +545,8 @@ void end_of_sim_cb(const vhpiCbDataT * cb_data) {
   vhpi_get_time(&t, &cycles);
   vhpi_printf("End of simulation (after %ld cycles and %ld ns).", cycles, convert_time_to_ns(&t));
 
+  flush_receive_stages();
+  plugin_runtime.reset();
   stop_rpc_server();
 }
 
@@ -145,6 +566,21 @@ void startup_register_foreign_methods(void)
 			       c_lib_name,
 			       vhpiProcF);
 
+  register_vhpi_foreign_method(vhpi_cosim_init_done,
+			       "vhpi_cosim_init_done",
+			       c_lib_name,
+			       vhpiProcF);
+
+  register_vhpi_foreign_method(vhpi_cosim_vvc_is_master,
+			       "vhpi_cosim_vvc_is_master",
+			       c_lib_name,
+			       vhpiFuncF);
+
+  register_vhpi_foreign_method(vhpi_cosim_vvc_packet_bridged,
+			       "vhpi_cosim_vvc_packet_bridged",
+			       c_lib_name,
+			       vhpiFuncF);
+
   register_vhpi_foreign_method(vhpi_cosim_transmit_queue_empty,
 			       "vhpi_cosim_transmit_queue_empty",
 			       c_lib_name,
@@ -160,6 +596,31 @@ void startup_register_foreign_methods(void)
 			       c_lib_name,
 			       vhpiProcF);
 
+  register_vhpi_foreign_method(vhpi_cosim_transmit_word_get,
+			       "vhpi_cosim_transmit_word_get",
+			       c_lib_name,
+			       vhpiProcF);
+
+  register_vhpi_foreign_method(vhpi_cosim_receive_word_put,
+			       "vhpi_cosim_receive_word_put",
+			       c_lib_name,
+			       vhpiProcF);
+
+  register_vhpi_foreign_method(vhpi_cosim_reg_queue_empty,
+			       "vhpi_cosim_reg_queue_empty",
+			       c_lib_name,
+			       vhpiFuncF);
+
+  register_vhpi_foreign_method(vhpi_cosim_reg_queue_get,
+			       "vhpi_cosim_reg_queue_get",
+			       c_lib_name,
+			       vhpiProcF);
+
+  register_vhpi_foreign_method(vhpi_cosim_reg_read_result_put,
+			       "vhpi_cosim_reg_read_result_put",
+			       c_lib_name,
+			       vhpiProcF);
+
   vhpi_printf("Registered all foreign functions/procedures");
 }
 
@@ -17,13 +17,18 @@ context bitvis_vip_uart.vvc_context;
 library bitvis_vip_axistream;
 context bitvis_vip_axistream.vvc_context;
 
+library bitvis_vip_axilite;
+context bitvis_vip_axilite.vvc_context;
+
 library work;
 use work.uvvm_cosim_utils_pkg.all;
 use work.vhpi_cosim_methods_pkg.all;
 
 entity uvvm_cosim is
   generic (
-    GC_SIM_RUN_CTRL_EN : boolean := false);
+    GC_SIM_RUN_CTRL_EN     : boolean := false;
+    GC_AXISTREAM_IF_WIDTHS : t_axistream_if_widths_array(0 to C_AXISTREAM_VVC_MAX_INSTANCE_NUM-1) :=
+      (others => C_AXISTREAM_IF_WIDTHS_DEFAULT));
   port (
     clk : in std_logic);
 end entity uvvm_cosim;
@@ -37,6 +42,7 @@ architecture func of uvvm_cosim is
   signal uart_rx_vvc_indexes_in_use : std_logic_vector(0 to C_UART_VVC_MAX_INSTANCE_NUM-1)      := (others => '0');
   signal uart_tx_vvc_indexes_in_use : std_logic_vector(0 to C_UART_VVC_MAX_INSTANCE_NUM-1)      := (others => '0');
   signal axis_vvc_indexes_in_use    : std_logic_vector(0 to C_AXISTREAM_VVC_MAX_INSTANCE_NUM-1) := (others => '0');
+  signal axilite_vvc_indexes_in_use : std_logic_vector(0 to C_AXILITE_VVC_MAX_INSTANCE_NUM-1)   := (others => '0');
 
 begin
 
@@ -86,7 +92,15 @@ begin
         axis_vvc_indexes_in_use(vvc_instance_id) <= '1';
 
         -- Comma-separated string with VVC config
-        vvc_cfg := bfm_cfg_to_string(shared_axistream_vvc_config(vvc_instance_id).bfm_config);
+        vvc_cfg := bfm_cfg_to_string(shared_axistream_vvc_config(vvc_instance_id).bfm_config,
+                                     GC_AXISTREAM_IF_WIDTHS(vvc_instance_id));
+
+      elsif strcmp("AXILITE_VVC", shared_vvc_activity_register.priv_get_vvc_name(idx)) then
+        -- Mark instance id as in use
+        axilite_vvc_indexes_in_use(vvc_instance_id) <= '1';
+
+        -- Comma-separated string with VVC config
+        vvc_cfg := bfm_cfg_to_string(shared_axilite_vvc_config(vvc_instance_id).bfm_config);
       else
         -- Unsupported VVC
         vvc_cfg := bfm_cfg_to_string(VOID);
@@ -107,6 +121,9 @@ begin
 
     end loop;
 
+    -- Starts the in-process plugin, if one is loaded
+    vhpi_cosim_init_done;
+
     init_done <= '1';
 
     wait;
@@ -129,7 +146,11 @@ begin
 
     inst_axis_vvc_ctrl: entity work.uvvm_cosim_axis_vvc_ctrl
       generic map (
-        GC_VVC_IDX => vvc_idx)
+        GC_VVC_IDX    => vvc_idx,
+        GC_DATA_WIDTH => GC_AXISTREAM_IF_WIDTHS(vvc_idx).data_width,
+        GC_USER_WIDTH => GC_AXISTREAM_IF_WIDTHS(vvc_idx).user_width,
+        GC_ID_WIDTH   => GC_AXISTREAM_IF_WIDTHS(vvc_idx).id_width,
+        GC_DEST_WIDTH => GC_AXISTREAM_IF_WIDTHS(vvc_idx).dest_width)
       port map (
         clk            => clk,
         vvc_idx_in_use => axis_vvc_indexes_in_use(vvc_idx),
@@ -137,4 +158,16 @@ begin
 
   end generate g_axis_vvc_ctrl;
 
+  g_axilite_vvc_ctrl: for vvc_idx in 0 to C_AXILITE_VVC_MAX_INSTANCE_NUM-1 generate
+
+    inst_axilite_vvc_ctrl: entity work.uvvm_cosim_axilite_vvc_ctrl
+      generic map (
+        GC_VVC_IDX => vvc_idx)
+      port map (
+        clk            => clk,
+        vvc_idx_in_use => axilite_vvc_indexes_in_use(vvc_idx),
+        init_done      => init_done);
+
+  end generate g_axilite_vvc_ctrl;
+
 end architecture func;
@@ -0,0 +1,106 @@
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library uvvm_util;
+context uvvm_util.uvvm_util_context;
+
+library uvvm_vvc_framework;
+use uvvm_vvc_framework.ti_vvc_framework_support_pkg.all;
+
+library bitvis_vip_axilite;
+context bitvis_vip_axilite.vvc_context;
+
+library work;
+use work.uvvm_cosim_utils_pkg.all;
+use work.vhpi_cosim_methods_pkg.all;
+
+entity uvvm_cosim_axilite_vvc_ctrl is
+  generic (
+    GC_VVC_IDX : natural);
+  port (
+    clk            : in std_logic;
+    vvc_idx_in_use : in std_logic;
+    init_done      : in std_logic);
+end entity uvvm_cosim_axilite_vvc_ctrl;
+
+
+architecture func of uvvm_cosim_axilite_vvc_ctrl is
+
+  constant C_SCOPE    : string := "UVVM_COSIM_AXILITE_VVC_CTRL";
+  constant C_VVC_TYPE : string := "AXILITE_VVC";
+
+begin
+
+  -- This process issues batches of register writes and reads from the cosim
+  -- register access queue to the AXI-Lite VVC. All accesses available in the
+  -- queue are issued back-to-back, and the results of the reads are collected
+  -- afterwards (in order) and returned to cosim.
+  p_reg_access : process
+    alias vvc_status         : t_vvc_status is shared_axilite_vvc_status(GC_VVC_IDX);
+    constant C_CMD_QUEUE_MAX : natural := 32;
+    constant C_READ_TIMEOUT  : time    := 100 ms;
+    variable v_is_write      : integer;
+    variable v_addr          : std_logic_vector(63 downto 0);
+    variable v_data          : std_logic_vector(63 downto 0);
+    variable v_result_data   : bitvis_vip_axilite.vvc_cmd_pkg.t_vvc_result;
+    variable v_read_cmd_idx  : t_integer_array(0 to C_CMD_QUEUE_MAX-1);
+    variable v_num_reads     : integer range 0 to C_CMD_QUEUE_MAX;
+  begin
+
+    wait until init_done = '1';
+    wait until rising_edge(clk);
+
+    -- Do nothing if no VVC was registered for this index
+    if vvc_idx_in_use = '0' then
+      wait;
+    end if;
+
+    log(ID_SEQUENCER, "Cosim for AXILITE VVC " & to_string(GC_VVC_IDX) & " ENABLED.", C_SCOPE);
+
+    loop
+      wait until rising_edge(clk);
+
+      v_num_reads := 0;
+
+      -- Issue register accesses from cosim queue
+      while vhpi_cosim_reg_queue_empty(C_VVC_TYPE, GC_VVC_IDX) = 0 loop
+
+        if vvc_status.pending_cmd_cnt >= C_CMD_QUEUE_MAX or v_num_reads = C_CMD_QUEUE_MAX then
+          -- Prevent command queue from overflowing, and collect results
+          -- for the reads issued so far before continuing
+          exit;
+        end if;
+
+        vhpi_cosim_reg_queue_get(C_VVC_TYPE, GC_VVC_IDX, v_is_write, v_addr, v_data);
+
+        if v_is_write = 1 then
+          axilite_write(AXILITE_VVCT, GC_VVC_IDX, unsigned(v_addr), v_data,
+                        "Write from uvvm_cosim_axilite_vvc_ctrl");
+        elsif v_is_write = 0 then
+          axilite_read(AXILITE_VVCT, GC_VVC_IDX, unsigned(v_addr),
+                       "Read from uvvm_cosim_axilite_vvc_ctrl");
+          v_read_cmd_idx(v_num_reads) := get_last_received_cmd_idx(AXILITE_VVCT, GC_VVC_IDX, NA, C_SCOPE);
+          v_num_reads                 := v_num_reads + 1;
+        end if;
+
+      end loop;
+
+      -- Return read results to cosim in the order the reads were issued
+      for read_num in 0 to v_num_reads-1 loop
+        await_completion(AXILITE_VVCT, GC_VVC_IDX, v_read_cmd_idx(read_num), C_READ_TIMEOUT,
+                         "Wait for register read on AXILITE VVC " & to_string(GC_VVC_IDX), C_SCOPE);
+
+        fetch_result(AXILITE_VVCT, GC_VVC_IDX, v_read_cmd_idx(read_num), v_result_data,
+                     "Fetch register read on AXILITE VVC " & to_string(GC_VVC_IDX), TB_ERROR, C_SCOPE);
+
+        v_data := std_logic_vector(resize(unsigned(v_result_data), v_data'length));
+
+        vhpi_cosim_reg_read_result_put(C_VVC_TYPE, GC_VVC_IDX, v_data);
+      end loop;
+
+    end loop;
+
+  end process p_reg_access;
+
+end architecture func;
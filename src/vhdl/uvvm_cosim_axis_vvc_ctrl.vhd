@@ -17,7 +17,11 @@ use work.vhpi_cosim_methods_pkg.all;
 
 entity uvvm_cosim_axis_vvc_ctrl is
   generic (
-    GC_VVC_IDX : natural);
+    GC_VVC_IDX    : natural;
+    GC_DATA_WIDTH : positive;
+    GC_USER_WIDTH : positive;
+    GC_ID_WIDTH   : positive;
+    GC_DEST_WIDTH : positive);
   port (
     clk            : in std_logic;
     vvc_idx_in_use : in std_logic;
@@ -30,30 +34,64 @@ architecture func of uvvm_cosim_axis_vvc_ctrl is
   constant C_SCOPE    : string := "UVVM_COSIM_AXIS_VVC_CTRL";
   constant C_VVC_TYPE : string := "AXISTREAM_VVC";
 
+  constant C_BYTES_PER_WORD : positive := GC_DATA_WIDTH/8;
+
+  -- tuser, tid and tdest are passed to and from the VVC in arrays with a
+  -- fixed element width, so the interface widths can't be wider than that.
+  -- Called when the constant below is elaborated.
+  function check_sideband_widths return boolean is
+  begin
+    assert GC_USER_WIDTH <= t_user_array'element'length
+      report "AXISTREAM VVC " & to_string(GC_VVC_IDX) & ": user_width " & to_string(GC_USER_WIDTH) &
+      " exceeds the VVC's max tuser width of " & to_string(t_user_array'element'length)
+      severity failure;
+    assert GC_ID_WIDTH <= t_id_array'element'length
+      report "AXISTREAM VVC " & to_string(GC_VVC_IDX) & ": id_width " & to_string(GC_ID_WIDTH) &
+      " exceeds the VVC's max tid width of " & to_string(t_id_array'element'length)
+      severity failure;
+    assert GC_DEST_WIDTH <= t_dest_array'element'length
+      report "AXISTREAM VVC " & to_string(GC_VVC_IDX) & ": dest_width " & to_string(GC_DEST_WIDTH) &
+      " exceeds the VVC's max tdest width of " & to_string(t_dest_array'element'length)
+      severity failure;
+    return true;
+  end function check_sideband_widths;
+
+  constant C_SIDEBAND_WIDTHS_OK : boolean := check_sideband_widths;
+
 begin
 
-  -- Note:
-  -- The GC_VVC_IS_MASTER parameter to the axistream_vvc entity is not exposed
-  -- or stored anywhere, so it's not possible to know if a given axistream VVC
-  -- instance is a transmitter or receiver.
-  -- (Technically, maybe it can be done if we write some fancy VHPI code to
-  -- search the simulation hierarchy, but that's not worth it).
-  -- Instead, both transmit and receive processes are active for any axistream
-  -- VVC. Which is not a problem, the user will just get an alert/error from
-  -- the VVC if it tries to issue transmit to a receiver instance and vice versa.
+  -- The direction of the VVC (GC_VVC_IS_MASTER on the axistream_vvc entity)
+  -- is found by the VHPI library from the design hierarchy, so only the
+  -- transmit process is active for masters and only the receive process for
+  -- slaves. If the direction could not be found, both are active.
 
+  -- Data is transferred from the cosim transmit queue one word (with sideband
+  -- signals) at a time, and collected in a buffer until end of packet (tlast)
+  -- or until the buffer is full, before it's transmitted with the VVC.
   p_transmit : process
     alias vvc_status         : t_vvc_status is shared_axistream_vvc_status(GC_VVC_IDX);
     constant C_CMD_QUEUE_MAX : natural := 32;
+    constant C_MAX_WORDS     : natural := C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES/C_BYTES_PER_WORD;
     variable v_data          : t_slv_array(0 to C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES-1)(7 downto 0);
+    variable v_user_array    : t_user_array(0 to C_MAX_WORDS-1);
+    variable v_strb_array    : t_strb_array(0 to C_MAX_WORDS-1) := (others => (others => '0'));
+    variable v_id_array      : t_id_array(0 to C_MAX_WORDS-1);
+    variable v_dest_array    : t_dest_array(0 to C_MAX_WORDS-1);
     variable v_byte_idx      : integer range 0 to C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES;
+    variable v_word_idx      : integer range 0 to C_MAX_WORDS;
+    variable v_tdata         : std_logic_vector(GC_DATA_WIDTH-1 downto 0);
+    variable v_tkeep         : std_logic_vector(C_BYTES_PER_WORD-1 downto 0);
+    variable v_tuser         : std_logic_vector(GC_USER_WIDTH-1 downto 0);
+    variable v_tid           : std_logic_vector(GC_ID_WIDTH-1 downto 0);
+    variable v_tdest         : std_logic_vector(GC_DEST_WIDTH-1 downto 0);
+    variable v_tlast         : integer;
   begin
 
     wait until init_done = '1';
     wait until rising_edge(clk);
 
-    -- Do nothing if no VVC was registered for this index
-    if vvc_idx_in_use = '0' then
+    -- Do nothing if no VVC was registered for this index, or it is a slave
+    if vvc_idx_in_use = '0' or vhpi_cosim_vvc_is_master(C_VVC_TYPE, GC_VVC_IDX) = 0 then
       wait;
     end if;
 
@@ -63,8 +101,9 @@ begin
       wait until rising_edge(clk);
 
       v_byte_idx := 0;
+      v_word_idx := 0;
 
-      -- Fetch bytes from cosim transmit queue
+      -- Fetch words from cosim transmit queue
       while vhpi_cosim_transmit_queue_empty(C_VVC_TYPE, GC_VVC_IDX) = 0 loop
 
         if vvc_status.pending_cmd_cnt >= C_CMD_QUEUE_MAX then
@@ -75,27 +114,47 @@ begin
           exit;
         end if;
 
-        if v_byte_idx = C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES then
+        if v_word_idx = C_MAX_WORDS then
           exit;
         end if;
 
-        -- TODO:
-        -- For packet based transmit collect data in an slv_array buffer
-        -- until the 9th bit in v_data (end of packet) is set.
-        v_data(v_byte_idx) := std_logic_vector(to_unsigned(vhpi_cosim_transmit_queue_get(C_VVC_TYPE, GC_VVC_IDX), v_data(0)'length));
+        vhpi_cosim_transmit_word_get(C_VVC_TYPE, GC_VVC_IDX,
+                                     v_tdata, v_tkeep, v_tuser, v_tid, v_tdest, v_tlast);
 
-        v_byte_idx := v_byte_idx + 1;
+        -- The VVC takes tkeep from the number of bytes transmitted,
+        -- so only the valid bytes of each word go in the data buffer
+        for byte_num in 0 to C_BYTES_PER_WORD-1 loop
+          if v_tkeep(byte_num) = '1' then
+            v_data(v_byte_idx) := v_tdata(8*byte_num+7 downto 8*byte_num);
+            v_byte_idx         := v_byte_idx + 1;
+          end if;
+        end loop;
+
+        v_user_array(v_word_idx) := std_logic_vector(resize(unsigned(v_tuser), v_user_array(0)'length));
+        v_id_array(v_word_idx)   := std_logic_vector(resize(unsigned(v_tid), v_id_array(0)'length));
+        v_dest_array(v_word_idx) := std_logic_vector(resize(unsigned(v_tdest), v_dest_array(0)'length));
+        v_word_idx               := v_word_idx + 1;
 
         if vhpi_cosim_transmit_queue_empty(C_VVC_TYPE, GC_VVC_IDX) = 1 then
           log(ID_SEQUENCER, "Transmit queue now empty for VVC index " & to_string(GC_VVC_IDX), C_SCOPE);
         end if;
 
+        -- Transmit one packet per VVC command
+        if v_tlast = 1 then
+          exit;
+        end if;
+
       end loop;
 
-      -- Transmit any bytes we got from cosim buffer
+      -- Transmit any data we got from cosim buffer
       if v_byte_idx > 0 then
         log(ID_SEQUENCER, "Got " & to_string(v_byte_idx) & " bytes to transmit on VVC " & to_string(GC_VVC_IDX), C_SCOPE);
-        axistream_transmit(AXISTREAM_VVCT, GC_VVC_IDX, v_data(0 to v_byte_idx-1),
+        axistream_transmit(AXISTREAM_VVCT, GC_VVC_IDX,
+                           v_data(0 to v_byte_idx-1),
+                           v_user_array(0 to v_word_idx-1),
+                           v_strb_array(0 to v_word_idx-1),
+                           v_id_array(0 to v_word_idx-1),
+                           v_dest_array(0 to v_word_idx-1),
                            "Transmit " & to_string(v_byte_idx) & " bytes from uvvm_cosim_axis_vvc_ctrl");
       end if;
 
@@ -114,6 +173,12 @@ begin
     variable v_result_data             : bitvis_vip_axistream.vvc_cmd_pkg.t_vvc_result;
 
     variable v_start_new_transaction   : boolean := true;
+    variable v_num_words               : natural;
+    variable v_byte_idx                : natural;
+    variable v_tdata                   : std_logic_vector(GC_DATA_WIDTH-1 downto 0);
+    variable v_tkeep                   : std_logic_vector(C_BYTES_PER_WORD-1 downto 0);
+    variable v_tlast                   : integer;
+    variable v_packet_bridged          : boolean;
 
     function listen_enable (void : t_void) return boolean is
     begin
@@ -129,10 +194,6 @@ begin
       if bfm_config.max_wait_cycles_severity /= NO_ALERT then
         alert(TB_ERROR, "AXISTREAM VVC " & to_string(GC_VVC_IDX) & ": Max wait cycles severity (timeout) should be set to NO_ALERT for cosim", C_SCOPE);
       end if;
-
-        if bfm_config.check_packet_length then
-          alert(TB_ERROR, "AXISTREAM VVC = " & to_string(GC_VVC_IDX) & ": Packet length (tlast) is not supported for cosim yet", C_SCOPE);
-        end if;
     end procedure check_bfm_config;
 
   begin
@@ -142,11 +203,13 @@ begin
     wait until init_done = '1';
     wait until rising_edge(clk);
 
-    -- Do nothing if no VVC was registered for this index
-    if vvc_idx_in_use = '0' then
+    -- Do nothing if no VVC was registered for this index, or it is a master
+    if vvc_idx_in_use = '0' or vhpi_cosim_vvc_is_master(C_VVC_TYPE, GC_VVC_IDX) = 1 then
       wait;
     end if;
 
+    v_packet_bridged := vhpi_cosim_vvc_packet_bridged(C_VVC_TYPE, GC_VVC_IDX) = 1;
+
     loop
 
       wait until rising_edge(clk);
@@ -177,14 +240,37 @@ begin
           else
             log(ID_SEQUENCER, "AXISTREAM VVC " & to_string(GC_VVC_IDX) & ": Transaction completed. Data: " & to_string(v_result_data.data_array(0 to v_result_data.data_length-1), HEX), C_SCOPE);
 
-            for byte_num in 0 to v_result_data.data_length-1 loop
-              vhpi_cosim_receive_queue_put(C_VVC_TYPE, GC_VVC_IDX,
-                                           to_integer(unsigned(v_result_data.data_array(byte_num))),
-                                           0 -- end_of_packet=false (not used)
-                                           );
-            -- TODO:
-            -- For packet based receive set the 9th bith (end of packet) in the
-            -- integer argument to vhpi_cosim_receive_queue_put on the last byte.
+            -- Pack received bytes into words with sideband signals
+            v_num_words := (v_result_data.data_length + C_BYTES_PER_WORD - 1) / C_BYTES_PER_WORD;
+
+            for word_num in 0 to v_num_words-1 loop
+              v_tdata := (others => '0');
+              v_tkeep := (others => '0');
+
+              for byte_num in 0 to C_BYTES_PER_WORD-1 loop
+                v_byte_idx := word_num*C_BYTES_PER_WORD + byte_num;
+
+                if v_byte_idx < v_result_data.data_length then
+                  v_tdata(8*byte_num+7 downto 8*byte_num) := v_result_data.data_array(v_byte_idx)(7 downto 0);
+                  v_tkeep(byte_num)                       := '1';
+                end if;
+              end loop;
+
+              -- Each transaction is one packet for packet based receive,
+              -- and when received packets are sent on by a bridge (UDP)
+              if (bfm_config.check_packet_length or v_packet_bridged) and word_num = v_num_words-1 then
+                v_tlast := 1;
+              else
+                v_tlast := 0;
+              end if;
+
+              vhpi_cosim_receive_word_put(C_VVC_TYPE, GC_VVC_IDX,
+                                          v_tdata,
+                                          v_tkeep,
+                                          v_result_data.user_array(word_num)(GC_USER_WIDTH-1 downto 0),
+                                          v_result_data.id_array(word_num)(GC_ID_WIDTH-1 downto 0),
+                                          v_result_data.dest_array(word_num)(GC_DEST_WIDTH-1 downto 0),
+                                          v_tlast);
             end loop;
 
           end if;
@@ -11,8 +11,29 @@ context bitvis_vip_uart.vvc_context;
 library bitvis_vip_axistream;
 context bitvis_vip_axistream.vvc_context;
 
+library bitvis_vip_axilite;
+context bitvis_vip_axilite.vvc_context;
+
 package uvvm_cosim_utils_pkg is
 
+  -- Interface widths of an AXI-Stream VVC. These are not available from the
+  -- VVC or BFM config, so they are set per VVC instance with a generic on
+  -- the uvvm_cosim entity.
+  type t_axistream_if_widths is record
+    data_width : positive;
+    user_width : positive;
+    id_width   : positive;
+    dest_width : positive;
+  end record t_axistream_if_widths;
+
+  type t_axistream_if_widths_array is array (natural range <>) of t_axistream_if_widths;
+
+  constant C_AXISTREAM_IF_WIDTHS_DEFAULT : t_axistream_if_widths := (
+    data_width => 8,
+    user_width => 1,
+    id_width   => 1,
+    dest_width => 1);
+
   function to_string(constant ch : t_channel) return string;
   function to_string(constant status : t_transaction_status) return string;
 
@@ -26,13 +47,18 @@ package uvvm_cosim_utils_pkg is
   -- types that we are interested in reporting to cosim.
 
   function bfm_cfg_to_string(
-    constant cfg : t_axistream_bfm_config)
+    constant cfg       : t_axistream_bfm_config;
+    constant if_widths : t_axistream_if_widths)
     return line;
 
   function bfm_cfg_to_string(
     constant cfg : t_uart_bfm_config)
     return line;
 
+  function bfm_cfg_to_string(
+    constant cfg : t_axilite_bfm_config)
+    return line;
+
   -- For unsupported VVCs/BFMs
   function bfm_cfg_to_string(
     constant void : t_void)
@@ -89,7 +115,8 @@ package body uvvm_cosim_utils_pkg is
   end function strcmp;
 
   function bfm_cfg_to_string(
-    constant cfg : t_axistream_bfm_config)
+    constant cfg       : t_axistream_bfm_config;
+    constant if_widths : t_axistream_if_widths)
     return line
   is
     variable v_line : line := new string'("");
@@ -101,6 +128,12 @@ package body uvvm_cosim_utils_pkg is
     else
       write(v_line, string'("packet_based=0,"));
     end if;
+
+    write(v_line, "data_width=" & to_string(if_widths.data_width) & ",");
+    write(v_line, "user_width=" & to_string(if_widths.user_width) & ",");
+    write(v_line, "id_width=" & to_string(if_widths.id_width) & ",");
+    write(v_line, "dest_width=" & to_string(if_widths.dest_width) & ",");
+    write(v_line, "max_packet_bytes=" & to_string(C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES) & ",");
     return v_line;
   end function bfm_cfg_to_string;
 
@@ -114,6 +147,17 @@ package body uvvm_cosim_utils_pkg is
     return v_line;
   end function bfm_cfg_to_string;
 
+  function bfm_cfg_to_string(
+    constant cfg : t_axilite_bfm_config)
+    return line
+  is
+    variable v_line : line := new string'("");
+  begin
+    write(v_line, string'("cosim_support=1,"));
+    write(v_line, string'("reg_access=1,"));
+    return v_line;
+  end function bfm_cfg_to_string;
+
   -- For unsupported VVCs/BFMs
   function bfm_cfg_to_string(
     constant void : t_void)
@@ -1,5 +1,8 @@
 -- Declarations of VHPI foreign functions/procedures/callbacks used for cosim
 
+library ieee;
+use ieee.std_logic_1164.all;
+
 library uvvm_util;
 context uvvm_util.uvvm_util_context;
 
@@ -14,6 +17,9 @@ package vhpi_cosim_methods_pkg is
     constant vvc_cfg         : in string
     );
 
+  -- Called when all VVCs have been reported with vhpi_cosim_report_vvc_info
+  procedure vhpi_cosim_init_done;
+
   -- TODO: Replace and add attribute for VHPI implementation
   function vhpi_cosim_vvc_listen_enable (
     constant vvc_type        : string;
@@ -21,6 +27,20 @@ package vhpi_cosim_methods_pkg is
     constant vvc_instance_id : integer)
     return boolean;
 
+  -- Direction of a VVC, found from the generics of the VVC instance in the
+  -- design hierarchy. Returns 1 for master (transmit), 0 for slave (receive),
+  -- and -1 if not known.
+  function vhpi_cosim_vvc_is_master(
+    constant vvc_type        : string;
+    constant vvc_instance_id : integer) return integer;
+
+  -- Returns 1 if the data received by the VVC is sent on as packets by a
+  -- bridge (UDP), so the end of each receive transaction must be marked as
+  -- end of packet, and 0 otherwise.
+  function vhpi_cosim_vvc_packet_bridged(
+    constant vvc_type        : string;
+    constant vvc_instance_id : integer) return integer;
+
   -- Returns bool as integer. True=1, False=0.
   function vhpi_cosim_transmit_queue_empty(
     constant vvc_type        : string;
@@ -38,11 +58,64 @@ package vhpi_cosim_methods_pkg is
     constant byte            : in integer;
     constant end_of_packet   : in integer);
 
+  -- Get next data word from the transmit queue of a VVC with word based
+  -- queues (AXI-Stream). tdata, tkeep, tuser, tid, and tdest should have the
+  -- widths of the VVC interface. tlast is 1 for the last word in a packet.
+  procedure vhpi_cosim_transmit_word_get(
+    constant vvc_type        : in  string;
+    constant vvc_instance_id : in  integer;
+    variable tdata           : out std_logic_vector;
+    variable tkeep           : out std_logic_vector;
+    variable tuser           : out std_logic_vector;
+    variable tid             : out std_logic_vector;
+    variable tdest           : out std_logic_vector;
+    variable tlast           : out integer);
+
+  procedure vhpi_cosim_receive_word_put(
+    constant vvc_type        : in string;
+    constant vvc_instance_id : in integer;
+    constant tdata           : in std_logic_vector;
+    constant tkeep           : in std_logic_vector;
+    constant tuser           : in std_logic_vector;
+    constant tid             : in std_logic_vector;
+    constant tdest           : in std_logic_vector;
+    constant tlast           : in integer);
+
+  -- Returns bool as integer. True=1, False=0.
+  function vhpi_cosim_reg_queue_empty(
+    constant vvc_type        : string;
+    constant vvc_instance_id : integer) return integer;
+
+  -- Get next register access from queue.
+  -- is_write is 1 for writes and 0 for reads (data is not used for reads).
+  -- addr and data should be 64 bits wide.
+  procedure vhpi_cosim_reg_queue_get(
+    constant vvc_type        : in  string;
+    constant vvc_instance_id : in  integer;
+    variable is_write        : out integer;
+    variable addr            : out std_logic_vector;
+    variable data            : out std_logic_vector);
+
+  -- Return result of register read. Must be called in the same order as
+  -- reads were retrieved with vhpi_cosim_reg_queue_get.
+  procedure vhpi_cosim_reg_read_result_put(
+    constant vvc_type        : in string;
+    constant vvc_instance_id : in integer;
+    constant data            : in std_logic_vector);
+
   attribute foreign of vhpi_cosim_start_sim            : procedure is "VHPI uvvm_cosim_lib vhpi_cosim_start_sim";
   attribute foreign of vhpi_cosim_report_vvc_info      : procedure is "VHPI uvvm_cosim_lib vhpi_cosim_report_vvc_info";
+  attribute foreign of vhpi_cosim_init_done            : procedure is "VHPI uvvm_cosim_lib vhpi_cosim_init_done";
+  attribute foreign of vhpi_cosim_vvc_is_master        : function is "VHPI uvvm_cosim_lib vhpi_cosim_vvc_is_master";
+  attribute foreign of vhpi_cosim_vvc_packet_bridged   : function is "VHPI uvvm_cosim_lib vhpi_cosim_vvc_packet_bridged";
   attribute foreign of vhpi_cosim_transmit_queue_empty : function is "VHPI uvvm_cosim_lib vhpi_cosim_transmit_queue_empty";
   attribute foreign of vhpi_cosim_transmit_queue_get   : function is "VHPI uvvm_cosim_lib vhpi_cosim_transmit_queue_get";
   attribute foreign of vhpi_cosim_receive_queue_put    : procedure is "VHPI uvvm_cosim_lib vhpi_cosim_receive_queue_put";
+  attribute foreign of vhpi_cosim_transmit_word_get    : procedure is "VHPI uvvm_cosim_lib vhpi_cosim_transmit_word_get";
+  attribute foreign of vhpi_cosim_receive_word_put     : procedure is "VHPI uvvm_cosim_lib vhpi_cosim_receive_word_put";
+  attribute foreign of vhpi_cosim_reg_queue_empty      : function is "VHPI uvvm_cosim_lib vhpi_cosim_reg_queue_empty";
+  attribute foreign of vhpi_cosim_reg_queue_get        : procedure is "VHPI uvvm_cosim_lib vhpi_cosim_reg_queue_get";
+  attribute foreign of vhpi_cosim_reg_read_result_put  : procedure is "VHPI uvvm_cosim_lib vhpi_cosim_reg_read_result_put";
 
 end package vhpi_cosim_methods_pkg;
 
@@ -64,6 +137,11 @@ package body vhpi_cosim_methods_pkg is
     report "Error: Should use foreign VHPI implementation" severity failure;
   end procedure;
 
+  procedure vhpi_cosim_init_done is
+  begin
+    report "Error: Should use foreign VHPI implementation" severity failure;
+  end procedure;
+
   -- TODO: Replace with VHPI implementation
   function vhpi_cosim_vvc_listen_enable (
     constant vvc_type        : string;
@@ -82,6 +160,20 @@ package body vhpi_cosim_methods_pkg is
     end if;
   end;
 
+  function vhpi_cosim_vvc_is_master(
+    constant vvc_type        :    string;
+    constant vvc_instance_id : in integer) return integer is
+  begin
+    report "Error: Should use foreign VHPI implementation" severity failure;
+  end function;
+
+  function vhpi_cosim_vvc_packet_bridged(
+    constant vvc_type        :    string;
+    constant vvc_instance_id : in integer) return integer is
+  begin
+    report "Error: Should use foreign VHPI implementation" severity failure;
+  end function;
+
   function vhpi_cosim_transmit_queue_empty(
     constant vvc_type        :    string;
     constant vvc_instance_id : in integer) return integer is
@@ -106,4 +198,59 @@ package body vhpi_cosim_methods_pkg is
     report "Error: Should use foreign VHPI implementation" severity failure;
   end procedure;
 
+  procedure vhpi_cosim_transmit_word_get(
+    constant vvc_type        : in  string;
+    constant vvc_instance_id : in  integer;
+    variable tdata           : out std_logic_vector;
+    variable tkeep           : out std_logic_vector;
+    variable tuser           : out std_logic_vector;
+    variable tid             : out std_logic_vector;
+    variable tdest           : out std_logic_vector;
+    variable tlast           : out integer
+    ) is
+  begin
+    report "Error: Should use foreign VHPI implementation" severity failure;
+  end procedure;
+
+  procedure vhpi_cosim_receive_word_put(
+    constant vvc_type        : in string;
+    constant vvc_instance_id : in integer;
+    constant tdata           : in std_logic_vector;
+    constant tkeep           : in std_logic_vector;
+    constant tuser           : in std_logic_vector;
+    constant tid             : in std_logic_vector;
+    constant tdest           : in std_logic_vector;
+    constant tlast           : in integer
+    ) is
+  begin
+    report "Error: Should use foreign VHPI implementation" severity failure;
+  end procedure;
+
+  function vhpi_cosim_reg_queue_empty(
+    constant vvc_type        :    string;
+    constant vvc_instance_id : in integer) return integer is
+  begin
+    report "Error: Should use foreign VHPI implementation" severity failure;
+  end function;
+
+  procedure vhpi_cosim_reg_queue_get(
+    constant vvc_type        : in  string;
+    constant vvc_instance_id : in  integer;
+    variable is_write        : out integer;
+    variable addr            : out std_logic_vector;
+    variable data            : out std_logic_vector
+    ) is
+  begin
+    report "Error: Should use foreign VHPI implementation" severity failure;
+  end procedure;
+
+  procedure vhpi_cosim_reg_read_result_put(
+    constant vvc_type        : in string;
+    constant vvc_instance_id : in integer;
+    constant data            : in std_logic_vector
+    ) is
+  begin
+    report "Error: Should use foreign VHPI implementation" severity failure;
+  end procedure;
+
 end package body vhpi_cosim_methods_pkg;
@@ -0,0 +1,18 @@
+#pragma once
+#include <iostream>
+
+// Minimal checks for the C++ unit tests, which are run by ctest. A failed
+// check is reported and counted, and the test returns non-zero at the end
+// with TEST_RESULT.
+
+inline int test_failures = 0;
+
+#define CHECK(cond)							\
+  do {									\
+    if (!(cond)) {							\
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed" << std::endl; \
+      test_failures++;							\
+    }									\
+  } while (0)
+
+#define TEST_RESULT() (test_failures == 0 ? 0 : 1)
@@ -0,0 +1,158 @@
+#include <cstdint>
+#include <vector>
+#include "data_source.hpp"
+#include "test_check.hpp"
+
+using Pattern = GeneratorSource::Pattern;
+
+// Read all data from a source in reads of up to chunk bytes, and record
+// the packet lengths
+static std::vector<uint8_t> read_all(DataSource& source, size_t chunk, std::vector<size_t>& packets)
+{
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> buf(chunk);
+  size_t packet = 0;
+
+  while (!source.Done()) {
+    bool end_of_packet;
+    size_t n = source.Read(buf.data(), buf.size(), end_of_packet);
+
+    data.insert(data.end(), buf.begin(), buf.begin() + n);
+    packet += n;
+
+    if (end_of_packet) {
+      packets.push_back(packet);
+      packet = 0;
+    }
+  }
+
+  return data;
+}
+
+// Bytes from a Fibonacci LFSR for the polynomial x^bits + x^tap + 1,
+// starting in state, with bits packed MSB first
+static std::vector<uint8_t> reference_prbs(int bits, int tap, uint64_t state, size_t length)
+{
+  std::vector<uint8_t> data;
+  uint64_t mask = (uint64_t(1) << bits) - 1;
+
+  for (size_t i = 0; i < length; i++) {
+    uint8_t byte = 0;
+
+    for (int b = 0; b < 8; b++) {
+      uint64_t bit = ((state >> (bits-1)) ^ (state >> (tap-1))) & 1;
+      state = ((state << 1) | bit) & mask;
+      byte = (byte << 1) | bit;
+    }
+
+    data.push_back(byte);
+  }
+
+  return data;
+}
+
+static void test_parse_pattern()
+{
+  CHECK(GeneratorSource::ParsePattern("prbs7") == Pattern::PRBS7);
+  CHECK(GeneratorSource::ParsePattern("prbs15") == Pattern::PRBS15);
+  CHECK(GeneratorSource::ParsePattern("prbs31") == Pattern::PRBS31);
+  CHECK(GeneratorSource::ParsePattern("counter") == Pattern::COUNTER);
+  CHECK(!GeneratorSource::ParsePattern("prbs23"));
+}
+
+static void test_counter()
+{
+  GeneratorSource source(Pattern::COUNTER, 0x1FE, 5, 0, 0);
+  std::vector<size_t> packets;
+
+  CHECK(read_all(source, 2, packets) == std::vector<uint8_t>({0xFE, 0xFF, 0x00, 0x01, 0x02}));
+  CHECK(packets.empty());
+  CHECK(source.Generated() == 5);
+}
+
+static void test_prbs()
+{
+  std::vector<size_t> packets;
+
+  GeneratorSource prbs7(Pattern::PRBS7, 0, 300, 0, 0);
+  CHECK(read_all(prbs7, 64, packets) == reference_prbs(7, 6, 0x7F, 300));
+
+  // PRBS7 repeats every 127 bits, so every 127 bytes
+  GeneratorSource period(Pattern::PRBS7, 0x55, 254, 0, 0);
+  auto data = read_all(period, 1000, packets);
+  CHECK(std::vector<uint8_t>(data.begin(), data.begin() + 127) ==
+	std::vector<uint8_t>(data.begin() + 127, data.end()));
+
+  GeneratorSource prbs15(Pattern::PRBS15, 0x1234, 100, 0, 0);
+  CHECK(read_all(prbs15, 7, packets) == reference_prbs(15, 14, 0x1234, 100));
+
+  // PRBS15 has the max length period of 32767 bits
+  GeneratorSource period15(Pattern::PRBS15, 1, 2*32767, 0, 0);
+  data = read_all(period15, 4096, packets);
+  CHECK(std::vector<uint8_t>(data.begin(), data.begin() + 32767) ==
+	std::vector<uint8_t>(data.begin() + 32767, data.end()));
+  CHECK(std::vector<uint8_t>(data.begin(), data.begin() + 16) !=
+	std::vector<uint8_t>(data.begin() + 127, data.begin() + 143));
+
+  GeneratorSource prbs31(Pattern::PRBS31, 0, 100, 0, 0);
+  CHECK(read_all(prbs31, 100, packets) == reference_prbs(31, 28, 0x7FFFFFFF, 100));
+  CHECK(packets.empty());
+}
+
+// Packet lengths are within the limits, the last packet ends with the
+// data, and the same parameters give the same data and packets
+static void test_packets()
+{
+  GeneratorSource a(Pattern::PRBS31, 42, 10000, 64, 1500);
+  GeneratorSource b(Pattern::PRBS31, 42, 10000, 64, 1500);
+  std::vector<size_t> packets_a;
+  std::vector<size_t> packets_b;
+
+  auto data_a = read_all(a, 4096, packets_a);
+  auto data_b = read_all(b, 100, packets_b);
+
+  CHECK(data_a.size() == 10000);
+  CHECK(data_a == data_b);
+  CHECK(packets_a == packets_b);
+  CHECK(!packets_a.empty());
+
+  size_t total = 0;
+  for (size_t i = 0; i < packets_a.size(); i++) {
+    total += packets_a[i];
+    if (i + 1 < packets_a.size()) {
+      CHECK(packets_a[i] >= 64 && packets_a[i] <= 1500);
+    }
+  }
+  CHECK(total == 10000);
+
+  GeneratorSource fixed(Pattern::COUNTER, 0, 100, 10, 10);
+  std::vector<size_t> packets;
+  read_all(fixed, 64, packets);
+  CHECK(packets == std::vector<size_t>(10, 10));
+}
+
+// A length of zero generates data until the source is removed
+static void test_unlimited()
+{
+  GeneratorSource source(Pattern::COUNTER, 0, 0, 0, 0);
+  uint8_t buf[1000];
+  bool end_of_packet;
+
+  for (int i = 0; i < 100; i++) {
+    CHECK(source.Read(buf, sizeof(buf), end_of_packet) == sizeof(buf));
+  }
+
+  CHECK(!source.Done());
+  CHECK(source.Generated() == 100000);
+}
+
+int main()
+{
+  test_parse_pattern();
+  test_counter();
+  test_prbs();
+  test_packets();
+  test_unlimited();
+
+  return TEST_RESULT();
+}
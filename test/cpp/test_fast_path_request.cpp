@@ -0,0 +1,96 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "nlohmann/json.hpp"
+#include "fast_path_request.hpp"
+#include "test_check.hpp"
+
+// Request parsed with the fast path SAX handler. valid is true if it is
+// handled by the fast path.
+struct Parsed {
+  std::vector<uint8_t> data;
+  FastPathRequest req{data};
+  bool valid;
+
+  explicit Parsed(const std::string& request)
+    : valid(nlohmann::json::sax_parse(request, &req) && req.Valid())
+  {
+  }
+};
+
+static bool parse(const std::string& request)
+{
+  return Parsed(request).valid;
+}
+
+static void test_transmit()
+{
+  Parsed p(R"({"jsonrpc":"2.0","method":"TransmitBytes","id":7,"params":["UART_VVC",1,[1,2,255]]})");
+  CHECK(p.valid);
+  CHECK(p.req.method == "TransmitBytes");
+  CHECK(p.req.id == 7);
+  CHECK(p.req.vvc_type == "UART_VVC");
+  CHECK(p.req.vvc_id == 1);
+  CHECK(p.data == std::vector<uint8_t>({1, 2, 255}));
+
+  // Named params, in any order, and a string id
+  Parsed named(R"({"params":{"data":[],"vvc_id":3,"vvc_type":"AXISTREAM_VVC"},"id":"a","method":"TransmitBytes","jsonrpc":"2.0"})");
+  CHECK(named.valid);
+  CHECK(named.req.id == "a");
+  CHECK(named.req.vvc_type == "AXISTREAM_VVC");
+  CHECK(named.req.vvc_id == 3);
+  CHECK(named.data.empty());
+}
+
+static void test_receive()
+{
+  Parsed p(R"({"jsonrpc":"2.0","method":"ReceiveBytes","id":1,"params":["UART_VVC",0,16,true]})");
+  CHECK(p.valid);
+  CHECK(p.req.method == "ReceiveBytes");
+  CHECK(p.req.length == 16);
+  CHECK(p.req.all_or_nothing);
+
+  Parsed named(R"({"jsonrpc":"2.0","method":"ReceiveBytes","id":1,"params":{"vvc_type":"UART_VVC","vvc_id":0,"all_or_nothing":false,"length":4}})");
+  CHECK(named.valid);
+  CHECK(named.req.length == 4);
+  CHECK(!named.req.all_or_nothing);
+}
+
+// Requests that must be left to the normal path
+static void test_fallback()
+{
+  // Other methods, and missing or extra fields
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"TransmitPacket","id":1,"params":["UART_VVC",0,[1]]})"));
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"TransmitBytes","id":1,"params":["UART_VVC",0]})"));
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"TransmitBytes","params":["UART_VVC",0,[1]]})"));
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"TransmitBytes","id":1,"params":["UART_VVC",0,[1],true]})"));
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"ReceiveBytes","id":1,"params":["UART_VVC",0,16]})"));
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"TransmitBytes","id":1,"params":{"vvc_type":"UART_VVC","vvc_id":0,"data":[1],"extra":1}})"));
+
+  // Duplicate fields, wrong version, and wrong types
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"TransmitBytes","method":"TransmitBytes","id":1,"params":["UART_VVC",0,[1]]})"));
+  CHECK(!parse(R"({"jsonrpc":"1.0","method":"TransmitBytes","id":1,"params":["UART_VVC",0,[1]]})"));
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"TransmitBytes","id":null,"params":["UART_VVC",0,[1]]})"));
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"TransmitBytes","id":1,"params":["UART_VVC","0",[1]]})"));
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"TransmitBytes","id":1,"params":["UART_VVC",0,[1.5]]})"));
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"TransmitBytes","id":1,"params":["UART_VVC",0,[[1]]]})"));
+
+  // Values out of range
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"TransmitBytes","id":1,"params":["UART_VVC",0,[256]]})"));
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"TransmitBytes","id":1,"params":["UART_VVC",0,[-1]]})"));
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"TransmitBytes","id":1,"params":["UART_VVC",4294967296,[1]]})"));
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"ReceiveBytes","id":1,"params":["UART_VVC",0,4294967296,false]})"));
+
+  // Invalid JSON and batches
+  CHECK(!parse(R"({"jsonrpc":"2.0","method":"TransmitBytes","id":1,"params":["UART_VVC",0,[1)"));
+  CHECK(!parse(R"([{"jsonrpc":"2.0","method":"TransmitBytes","id":1,"params":["UART_VVC",0,[1]]}])"));
+}
+
+int main()
+{
+  test_transmit();
+  test_receive();
+  test_fallback();
+
+  return TEST_RESULT();
+}
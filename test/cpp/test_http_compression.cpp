@@ -0,0 +1,118 @@
+#include <string>
+#include "http_compression.hpp"
+#include "test_check.hpp"
+
+// JSON-RPC request with a large data array, as sent by TransmitBytes
+static std::string make_request(size_t num_bytes)
+{
+  std::string request = "{\"id\":1,\"jsonrpc\":\"2.0\",\"method\":\"TransmitBytes\",\"params\":[\"AXISTREAM_VVC\",0,[";
+
+  for (size_t i = 0; i < num_bytes; i++) {
+    request += (i > 0 ? "," : "") + std::to_string(i * 7 % 256);
+  }
+
+  return request + "]]}";
+}
+
+static void test_parse_coding()
+{
+  CHECK(parse_content_coding("") == ContentCoding::IDENTITY);
+  CHECK(parse_content_coding(" Identity ") == ContentCoding::IDENTITY);
+  CHECK(!parse_content_coding("br"));
+  CHECK(!parse_content_coding("gzip, zstd"));
+  CHECK(parse_content_coding("GZIP").has_value() == content_coding_supported(ContentCoding::GZIP));
+  CHECK(parse_content_coding("x-gzip").has_value() == content_coding_supported(ContentCoding::GZIP));
+  CHECK(parse_content_coding("zstd").has_value() == content_coding_supported(ContentCoding::ZSTD));
+}
+
+static void test_negotiate()
+{
+  CHECK(negotiate_content_coding("") == ContentCoding::IDENTITY);
+  CHECK(negotiate_content_coding("br, deflate") == ContentCoding::IDENTITY);
+  CHECK(negotiate_content_coding("gzip;q=0") == ContentCoding::IDENTITY);
+  CHECK(negotiate_content_coding("gzip;q=0.0, zstd;q=0") == ContentCoding::IDENTITY);
+
+  ContentCoding gzip = content_coding_supported(ContentCoding::GZIP) ? ContentCoding::GZIP : ContentCoding::IDENTITY;
+  ContentCoding zstd = content_coding_supported(ContentCoding::ZSTD) ? ContentCoding::ZSTD : gzip;
+
+  CHECK(negotiate_content_coding("gzip") == gzip);
+  CHECK(negotiate_content_coding("gzip;q=0.5") == gzip);
+  CHECK(negotiate_content_coding("deflate, gzip , br") == gzip);
+  CHECK(negotiate_content_coding("gzip, zstd") == zstd);
+  CHECK(negotiate_content_coding("zstd;q=0, gzip") == gzip);
+}
+
+static void test_supported_codings()
+{
+  std::string codings = supported_content_codings();
+
+  CHECK((codings.find("gzip") != std::string::npos) == content_coding_supported(ContentCoding::GZIP));
+  CHECK((codings.find("zstd") != std::string::npos) == content_coding_supported(ContentCoding::ZSTD));
+  CHECK(negotiate_content_coding(codings) != ContentCoding::IDENTITY || codings.empty());
+}
+
+// Round trip through each supported coding, with bodies smaller and larger
+// than a compressor chunk
+static void test_round_trip()
+{
+  for (auto coding : {ContentCoding::IDENTITY, ContentCoding::GZIP, ContentCoding::ZSTD}) {
+    if (!content_coding_supported(coding)) {
+      std::string out;
+      CHECK(!compress_content(coding, "data", out));
+      CHECK(!decompress_content(coding, "data", out));
+      continue;
+    }
+
+    for (size_t num_bytes : {0, 10, 100000}) {
+      std::string request = make_request(num_bytes);
+      std::string compressed;
+      std::string decompressed;
+
+      CHECK(compress_content(coding, request, compressed));
+      CHECK(decompress_content(coding, compressed, decompressed));
+      CHECK(decompressed == request);
+
+      if (coding != ContentCoding::IDENTITY) {
+	CHECK(has_content_coding_magic(coding, compressed));
+	CHECK(!has_content_coding_magic(coding, request));
+
+	if (num_bytes == 100000) {
+	  CHECK(compressed.size() < request.size() / 4);
+	}
+      }
+    }
+  }
+}
+
+// Invalid data, truncated data, and data that decompresses to more than
+// the max size are rejected
+static void test_invalid()
+{
+  std::string request = make_request(100000);
+
+  for (auto coding : {ContentCoding::GZIP, ContentCoding::ZSTD}) {
+    if (!content_coding_supported(coding)) {
+      continue;
+    }
+
+    std::string compressed;
+    std::string out;
+
+    CHECK(compress_content(coding, request, compressed));
+    CHECK(!decompress_content(coding, request, out));
+    CHECK(!decompress_content(coding, compressed.substr(0, compressed.size() / 2), out));
+    CHECK(!decompress_content(coding, compressed, out, request.size() - 1));
+    CHECK(decompress_content(coding, compressed, out, request.size()));
+  }
+}
+
+int main()
+{
+  test_parse_coding();
+  test_negotiate();
+  test_supported_codings();
+  test_round_trip();
+  test_invalid();
+
+  return TEST_RESULT();
+}
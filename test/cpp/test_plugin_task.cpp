@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "uvvm_cosim_plugin.hpp"
+#include "test_check.hpp"
+
+// Plugin context with VVC queues in memory, resuming tasks the same way
+// as PluginRuntime: spawned tasks and time waits are resumed by Poll, and
+// waiters are checked once per Poll.
+class TestContext : public PluginContext {
+public:
+  std::list<PluginTask> tasks;
+  std::vector<std::coroutine_handle<>> ready;
+  std::vector<PluginWaiter*> waiters;
+  std::multimap<uint64_t, std::coroutine_handle<>> timeWaits;
+  uint64_t now = 0;
+
+  // Data put in the transmit queue of a VVC, and data that a VVC has
+  // received
+  std::map<int, std::vector<uint8_t>> transmitted;
+  std::map<int, std::deque<uint8_t>> received;
+  std::map<int, bool> transmitBusy;
+
+  void Poll(uint64_t sim_time)
+  {
+    now = sim_time;
+
+    while (!timeWaits.empty() && timeWaits.begin()->first <= now) {
+      ready.push_back(timeWaits.begin()->second);
+      timeWaits.erase(timeWaits.begin());
+    }
+
+    for (auto it = waiters.begin(); it != waiters.end();) {
+      if ((*it)->Ready()) {
+	ready.push_back((*it)->handle);
+	it = waiters.erase(it);
+      } else {
+	++it;
+      }
+    }
+
+    while (!ready.empty()) {
+      auto resume = std::move(ready);
+      ready.clear();
+
+      for (auto handle : resume) {
+	handle.resume();
+      }
+    }
+  }
+
+  void Spawn(PluginTask task) override
+  {
+    tasks.push_back(std::move(task));
+    ready.push_back(tasks.back().Handle());
+  }
+
+  uint64_t SimTime() override
+  {
+    return now;
+  }
+
+  bool HasVvc(const std::string& vvc_type, int) override
+  {
+    return vvc_type == "UART_VVC";
+  }
+
+  void TransmitPut(const std::string&, int vvc_instance_id,
+		   const uint8_t* data, size_t length, bool) override
+  {
+    transmitted[vvc_instance_id].insert(transmitted[vvc_instance_id].end(), data, data + length);
+    transmitBusy[vvc_instance_id] = true;
+  }
+
+  bool TransmitIdle(const std::string&, int vvc_instance_id) override
+  {
+    return !transmitBusy[vvc_instance_id];
+  }
+
+  size_t ReceiveGet(const std::string&, int vvc_instance_id,
+		    size_t max_bytes, std::vector<uint8_t>& data) override
+  {
+    auto& q = received[vvc_instance_id];
+    size_t n = std::min(max_bytes, q.size());
+
+    data.insert(data.end(), q.begin(), q.begin() + n);
+    q.erase(q.begin(), q.begin() + n);
+
+    return n;
+  }
+
+  void Suspend(PluginWaiter& waiter) override
+  {
+    waiters.push_back(&waiter);
+  }
+
+  void SuspendUntil(uint64_t sim_time, std::coroutine_handle<> handle) override
+  {
+    timeWaits.emplace(sim_time, handle);
+  }
+};
+
+static PluginTask add_one(int& value)
+{
+  value++;
+  co_return;
+}
+
+static PluginTask fail()
+{
+  throw std::runtime_error("failed");
+  co_return;
+}
+
+// Tasks are not started until spawned, and awaiting a task runs it to
+// completion before the awaiting task continues
+static void test_spawn_and_await()
+{
+  TestContext ctx;
+  int value = 0;
+  std::vector<int> order;
+
+  auto outer = [&]() -> PluginTask {
+    order.push_back(1);
+    co_await add_one(value);
+    order.push_back(value);
+    co_await add_one(value);
+    order.push_back(value);
+  };
+
+  PluginTask task = outer();
+  CHECK(!task.Done());
+  CHECK(order.empty());
+
+  ctx.Spawn(std::move(task));
+  CHECK(task.Done());  // Moved from
+  CHECK(order.empty());
+
+  ctx.Poll(0);
+  CHECK(order == std::vector<int>({1, 1, 2}));
+  CHECK(ctx.tasks.front().Done());
+}
+
+// Exceptions in an awaited task are rethrown in the awaiting task, and
+// kept in the promise of a top level task
+static void test_exceptions()
+{
+  TestContext ctx;
+  bool caught = false;
+
+  auto outer = [&]() -> PluginTask {
+    try {
+      co_await fail();
+    } catch (std::runtime_error&) {
+      caught = true;
+    }
+  };
+
+  ctx.Spawn(outer());
+  ctx.Spawn(fail());
+  ctx.Poll(0);
+
+  CHECK(caught);
+  CHECK(ctx.tasks.front().Done());
+  CHECK(!ctx.tasks.front().Handle().promise().exception);
+  CHECK(ctx.tasks.back().Done());
+  CHECK(ctx.tasks.back().Handle().promise().exception);
+}
+
+// Time waits resume the task at the requested time, in fs
+static void test_delay()
+{
+  TestContext ctx;
+  std::vector<uint64_t> times;
+
+  auto task = [&]() -> PluginTask {
+    times.push_back(ctx.SimTime());
+    co_await ctx.Delay(10.0);
+    times.push_back(ctx.SimTime());
+    co_await ctx.WaitUntil(5.0);  // Already passed
+    times.push_back(ctx.SimTime());
+    co_await ctx.WaitUntil(25.5);
+    times.push_back(ctx.SimTime());
+  };
+
+  ctx.Spawn(task());
+  ctx.Poll(1000000);
+  ctx.Poll(10000000);
+  ctx.Poll(11000000);
+  CHECK(times == std::vector<uint64_t>({1000000, 11000000, 11000000}));
+
+  ctx.Poll(25499999);
+  CHECK(times.size() == 3);
+  ctx.Poll(25500000);
+  CHECK(times.size() == 4);
+  CHECK(ctx.tasks.front().Done());
+}
+
+// Transmit resumes when the transmit queue is idle, and Receive when the
+// requested number of bytes has been received
+static void test_vvc()
+{
+  TestContext ctx;
+  std::vector<uint8_t> data;
+  bool transmitted = false;
+  bool missing_vvc = false;
+
+  auto task = [&]() -> PluginTask {
+    try {
+      ctx.Vvc("AXISTREAM_VVC", 0);
+    } catch (std::invalid_argument&) {
+      missing_vvc = true;
+    }
+
+    auto uart = ctx.Vvc("UART_VVC", 1);
+    std::vector<uint8_t> bytes = {1, 2, 3};
+
+    co_await uart.Transmit(bytes);
+    transmitted = true;
+    data = co_await uart.Receive(4);
+  };
+
+  ctx.Spawn(task());
+  ctx.Poll(0);
+  CHECK(missing_vvc);
+  CHECK(ctx.transmitted[1] == std::vector<uint8_t>({1, 2, 3}));
+  CHECK(!transmitted);
+
+  ctx.transmitBusy[1] = false;
+  ctx.received[1] = {10, 11};
+  ctx.Poll(1);
+  CHECK(transmitted);
+  CHECK(data.empty());
+
+  // Partial data is taken from the queue while waiting
+  ctx.Poll(2);
+  CHECK(ctx.received[1].empty());
+  CHECK(!ctx.tasks.front().Done());
+
+  ctx.received[1] = {12, 13, 14};
+  ctx.Poll(3);
+  CHECK(data == std::vector<uint8_t>({10, 11, 12, 13}));
+  CHECK(ctx.received[1] == std::deque<uint8_t>({14}));
+  CHECK(ctx.tasks.front().Done());
+}
+
+int main()
+{
+  test_spawn_and_await();
+  test_exceptions();
+  test_delay();
+  test_vvc();
+
+  return TEST_RESULT();
+}
@@ -0,0 +1,114 @@
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "timestamp_log.hpp"
+#include "test_check.hpp"
+
+using Chunk = std::pair<uint64_t, uint64_t>; // time, num_bytes
+
+static std::vector<TimestampLog::Chunk> read_all(const TimestampLog& log)
+{
+  std::vector<TimestampLog::Chunk> chunks;
+  TimestampLog::Reader reader(log);
+  TimestampLog::Chunk chunk;
+
+  while (reader.Next(chunk)) {
+    chunks.push_back(chunk);
+  }
+
+  return chunks;
+}
+
+static std::vector<Chunk> pop(TimestampLog& log, uint64_t num_bytes)
+{
+  std::vector<Chunk> chunks;
+
+  log.PopFront(num_bytes, [&](uint64_t time, uint64_t n) { chunks.emplace_back(time, n); });
+
+  return chunks;
+}
+
+// Bytes at the same time are merged into one chunk, unless the chunk
+// ends a packet
+static void test_append()
+{
+  TimestampLog log;
+
+  log.Append(100, 3);
+  log.Append(100, 2);
+  log.Append(200, 4, true);
+  log.Append(200, 1);
+  log.Append(200, 0);
+
+  auto chunks = read_all(log);
+
+  CHECK(chunks.size() == 3);
+  CHECK(chunks[0].time == 100 && chunks[0].num_bytes == 5 && !chunks[0].end_of_packet);
+  CHECK(chunks[1].time == 200 && chunks[1].num_bytes == 4 && chunks[1].end_of_packet);
+  CHECK(chunks[2].time == 200 && chunks[2].num_bytes == 1 && !chunks[2].end_of_packet);
+}
+
+// Popping across chunk boundaries, and partial chunks
+static void test_pop()
+{
+  TimestampLog log;
+
+  log.Append(10, 4);
+  log.Append(20, 4, true);
+  log.Append(30, 4);
+
+  CHECK(pop(log, 2) == std::vector<Chunk>({{10, 2}}));
+  CHECK(pop(log, 4) == std::vector<Chunk>({{10, 2}, {20, 2}}));
+
+  auto chunks = read_all(log);
+
+  CHECK(chunks.size() == 2);
+  CHECK(chunks[0].time == 20 && chunks[0].num_bytes == 2 && chunks[0].end_of_packet);
+  CHECK(chunks[1].time == 30 && chunks[1].num_bytes == 4);
+
+  // Appending to a partly popped last chunk still merges
+  CHECK(pop(log, 3) == std::vector<Chunk>({{20, 2}, {30, 1}}));
+  log.Append(30, 2);
+  CHECK(read_all(log).size() == 1);
+  CHECK(pop(log, 100) == std::vector<Chunk>({{30, 5}}));
+  CHECK(log.Empty());
+}
+
+// Times that don't fit in one varint byte, and times that decrease
+static void test_large_times()
+{
+  TimestampLog log;
+  uint64_t t0 = uint64_t(1) << 40;
+  uint64_t t1 = t0 + 123456789;
+
+  log.Append(t0, 1000000);
+  log.Append(t1, 1);
+  log.Append(t0, 1);  // Treated as t1
+
+  CHECK(pop(log, 1000002) == std::vector<Chunk>({{t0, 1000000}, {t1, 2}}));
+  CHECK(log.Empty());
+  CHECK(log.EncodedSize() == 0);
+}
+
+// Clear keeps the time base, so later deltas stay correct
+static void test_clear()
+{
+  TimestampLog log;
+
+  log.Append(500, 8);
+  log.Clear();
+  CHECK(log.Empty());
+
+  log.Append(700, 2);
+  CHECK(pop(log, 2) == std::vector<Chunk>({{700, 2}}));
+}
+
+int main()
+{
+  test_append();
+  test_pop();
+  test_large_times();
+  test_clear();
+
+  return TEST_RESULT();
+}
@@ -0,0 +1,123 @@
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "timing_wheel.hpp"
+#include "test_check.hpp"
+
+using Wheel = TimingWheel<int>;
+
+// Advance to now and return the items that were due
+static std::vector<int> advance(Wheel& wheel, uint64_t now)
+{
+  std::vector<int> due;
+
+  wheel.Advance(now, [&](int item) { due.push_back(item); });
+
+  return due;
+}
+
+// Items on the lowest level, in time order and in scheduling order for
+// items at the same time
+static void test_level0()
+{
+  Wheel wheel;
+
+  wheel.Schedule(5, 1);
+  wheel.Schedule(3, 2);
+  wheel.Schedule(5, 3);
+
+  CHECK(wheel.Size() == 3);
+  CHECK(wheel.NextDue() == 3);
+  CHECK(advance(wheel, 2).empty());
+  CHECK(advance(wheel, 4) == std::vector<int>({2}));
+  CHECK(wheel.NextDue() == 5);
+  CHECK(advance(wheel, 5) == std::vector<int>({1, 3}));
+  CHECK(wheel.Empty());
+  CHECK(wheel.NextDue() == Wheel::C_NEVER);
+}
+
+// Items on the upper levels are cascaded down when their slot is reached
+static void test_cascade()
+{
+  Wheel wheel;
+
+  wheel.Schedule(300, 1);         // Level 1
+  wheel.Schedule(70000, 2);       // Level 2
+  wheel.Schedule(20000000, 3);    // Level 3
+  wheel.Schedule(256, 4);         // Level 1, start of slot
+
+  CHECK(wheel.NextDue() == 256);
+  CHECK(advance(wheel, 255).empty());
+  CHECK(advance(wheel, 256) == std::vector<int>({4}));
+  CHECK(advance(wheel, 299).empty());
+  CHECK(advance(wheel, 300) == std::vector<int>({1}));
+  CHECK(wheel.NextDue() == 70000);
+  CHECK(advance(wheel, 69999).empty());
+  CHECK(advance(wheel, 70000) == std::vector<int>({2}));
+  CHECK(advance(wheel, 19999999).empty());
+  CHECK(advance(wheel, 20000000) == std::vector<int>({3}));
+  CHECK(wheel.Empty());
+}
+
+// Advancing in one call past several levels passes the items in order
+static void test_advance_far()
+{
+  Wheel wheel(1000);
+
+  wheel.Schedule(5000000, 3);
+  wheel.Schedule(1001, 1);
+  wheel.Schedule(66000, 2);
+
+  CHECK(advance(wheel, 10000000) == std::vector<int>({1, 2, 3}));
+  CHECK(wheel.Empty());
+}
+
+// Items beyond the top level are kept in the overflow list until the
+// wheel reaches their rotation
+static void test_overflow()
+{
+  Wheel wheel;
+  uint64_t far = (uint64_t(1) << 32) + 10;
+  uint64_t farther = (uint64_t(3) << 32) + 7;
+
+  wheel.Schedule(farther, 2);
+  wheel.Schedule(far, 1);
+  wheel.Schedule(100, 0);
+
+  CHECK(wheel.NextDue() == 100);
+  CHECK(advance(wheel, 100) == std::vector<int>({0}));
+  CHECK(wheel.NextDue() == far);
+  CHECK(advance(wheel, far - 1).empty());
+  CHECK(advance(wheel, far) == std::vector<int>({1}));
+  CHECK(wheel.NextDue() == farther);
+  CHECK(advance(wheel, farther) == std::vector<int>({2}));
+  CHECK(wheel.Empty());
+}
+
+// Items scheduled in the past are due at the next Advance
+static void test_past()
+{
+  Wheel wheel;
+
+  CHECK(advance(wheel, 1000).empty());
+
+  wheel.Schedule(10, 1);
+  CHECK(wheel.NextDue() == 1001);
+  CHECK(advance(wheel, 1001) == std::vector<int>({1}));
+
+  wheel.Schedule(uint64_t(1) << 40, 2);
+  wheel.Schedule(2000, 3);
+  CHECK(advance(wheel, uint64_t(1) << 41) == std::vector<int>({3, 2}));
+  CHECK(wheel.Empty());
+}
+
+int main()
+{
+  test_level0();
+  test_cascade();
+  test_advance_far();
+  test_overflow();
+  test_past();
+
+  return TEST_RESULT();
+}
@@ -1,6 +1,7 @@
 --hdlregression:tb
 library ieee;
 use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
 
 library uvvm_util;
 context uvvm_util.uvvm_util_context;
@@ -14,6 +15,9 @@ context bitvis_vip_uart.vvc_context;
 library bitvis_vip_axistream;
 context bitvis_vip_axistream.vvc_context;
 
+library bitvis_vip_axilite;
+context bitvis_vip_axilite.vvc_context;
+
 library bitvis_vip_clock_generator;
 context bitvis_vip_clock_generator.vvc_context;
 
@@ -44,6 +48,25 @@ architecture sim of tb is
   signal axistream_if_transmit : t_axistream_8b;
   signal axistream_if_receive  : t_axistream_8b;
 
+  subtype t_axilite_32b is t_axilite_if(write_address_channel(awaddr(31 downto 0)),
+                                        write_data_channel(wdata(31 downto 0),
+                                                           wstrb(3 downto 0)),
+                                        read_address_channel(araddr(31 downto 0)),
+                                        read_data_channel(rdata(31 downto 0))
+                                        );
+
+  signal axilite_if : t_axilite_32b;
+
+  -- Register file used as AXI-Lite slave
+  constant C_AXILITE_NUM_REGS : natural := 16;
+
+  signal axilite_awready : std_logic                     := '0';
+  signal axilite_wready  : std_logic                     := '0';
+  signal axilite_bvalid  : std_logic                     := '0';
+  signal axilite_arready : std_logic                     := '0';
+  signal axilite_rvalid  : std_logic                     := '0';
+  signal axilite_rdata   : std_logic_vector(31 downto 0) := (others => '0');
+
 begin
 
   uart0_rx <= uart1_tx after 10 ns;
@@ -67,6 +90,15 @@ begin
   axistream_if_receive.tlast   <= axistream_if_transmit.tlast;
   axistream_if_transmit.tready <= axistream_if_receive.tready;
 
+  axilite_if.write_address_channel.awready <= axilite_awready;
+  axilite_if.write_data_channel.wready     <= axilite_wready;
+  axilite_if.write_response_channel.bvalid <= axilite_bvalid;
+  axilite_if.write_response_channel.bresp  <= "00";
+  axilite_if.read_address_channel.arready  <= axilite_arready;
+  axilite_if.read_data_channel.rvalid      <= axilite_rvalid;
+  axilite_if.read_data_channel.rdata       <= axilite_rdata;
+  axilite_if.read_data_channel.rresp       <= "00";
+
   inst_uvvm_cosim: entity work.uvvm_cosim
     generic map (
       GC_SIM_RUN_CTRL_EN => true)
@@ -130,6 +162,59 @@ begin
       axistream_vvc_if => axistream_if_receive
       );
 
+  i_axilite_vvc0 : entity bitvis_vip_axilite.axilite_vvc
+    generic map (
+      GC_ADDR_WIDTH   => 32,
+      GC_DATA_WIDTH   => 32,
+      GC_INSTANCE_IDX => 0
+      )
+    port map (
+      clk                   => clk,
+      axilite_vvc_master_if => axilite_if
+      );
+
+  -- Simple AXI-Lite slave with a small register file, for testing
+  -- register access via cosim on AXI-Lite VVC 0
+  p_axilite_regs : process (clk)
+    type t_reg_array is array (0 to C_AXILITE_NUM_REGS-1) of std_logic_vector(31 downto 0);
+    variable v_regs    : t_reg_array := (others => (others => '0'));
+    variable v_reg_idx : natural range 0 to C_AXILITE_NUM_REGS-1;
+  begin
+    if rising_edge(clk) then
+      axilite_awready <= '0';
+      axilite_wready  <= '0';
+      axilite_arready <= '0';
+
+      -- Write: Accept address and data together, then respond
+      if axilite_bvalid = '1' then
+        if axilite_if.write_response_channel.bready = '1' then
+          axilite_bvalid <= '0';
+        end if;
+      elsif axilite_if.write_address_channel.awvalid = '1' and
+        axilite_if.write_data_channel.wvalid = '1' and
+        axilite_awready = '0'
+      then
+        v_reg_idx         := to_integer(unsigned(axilite_if.write_address_channel.awaddr(5 downto 2)));
+        v_regs(v_reg_idx) := axilite_if.write_data_channel.wdata;
+        axilite_awready   <= '1';
+        axilite_wready    <= '1';
+        axilite_bvalid    <= '1';
+      end if;
+
+      -- Read: Accept address, then respond with data
+      if axilite_rvalid = '1' then
+        if axilite_if.read_data_channel.rready = '1' then
+          axilite_rvalid <= '0';
+        end if;
+      elsif axilite_if.read_address_channel.arvalid = '1' and axilite_arready = '0' then
+        v_reg_idx       := to_integer(unsigned(axilite_if.read_address_channel.araddr(5 downto 2)));
+        axilite_rdata   <= v_regs(v_reg_idx);
+        axilite_arready <= '1';
+        axilite_rvalid  <= '1';
+      end if;
+    end if;
+  end process p_axilite_regs;
+
 
   p_test : process
     variable v_uart_bfm_config      : t_uart_bfm_config      := C_UART_BFM_CONFIG_DEFAULT;
@@ -162,6 +247,9 @@ begin
     enable_log_msg(AXISTREAM_VVCT, 0, NA, ID_BFM);
     enable_log_msg(AXISTREAM_VVCT, 1, NA, ID_BFM);
 
+    disable_log_msg(AXILITE_VVCT, 0, NA, ALL_MESSAGES);
+    enable_log_msg(AXILITE_VVCT, 0, NA, ID_BFM);
+
     -----------------------------------------------------------------------------
     -- UART VVC config
     -----------------------------------------------------------------------------
@@ -192,12 +280,28 @@ begin
     shared_axistream_vvc_config(0).bfm_config := v_axistream_bfm_config;
     shared_axistream_vvc_config(1).bfm_config := v_axistream_bfm_config;
 
+    -----------------------------------------------------------------------------
+    -- AXI-Lite VVC config
+    -----------------------------------------------------------------------------
+    shared_axilite_vvc_config(0).bfm_config.clock_period := C_CLK_PERIOD;
+
     -----------------------------------------------------------------------------
     -- Start clock
     -----------------------------------------------------------------------------
     wait for C_CLK_PERIOD;
     start_clock(CLOCK_GENERATOR_VVCT, 0, "Start clock generator");
 
+    -----------------------------------------------------------------------------
+    -- Check the AXI-Lite register file, using the last registers so the
+    -- registers used by cosim clients are left alone
+    -----------------------------------------------------------------------------
+    log(ID_LOG_HDR, "Check AXI-Lite register file", C_SCOPE);
+    axilite_write(AXILITE_VVCT, 0, unsigned'(x"00000038"), x"DEADBEEF", "Write register 14");
+    axilite_write(AXILITE_VVCT, 0, unsigned'(x"0000003C"), x"01234567", "Write register 15");
+    axilite_check(AXILITE_VVCT, 0, unsigned'(x"00000038"), x"DEADBEEF", "Check register 14");
+    axilite_check(AXILITE_VVCT, 0, unsigned'(x"0000003C"), x"01234567", "Check register 15");
+    await_completion(AXILITE_VVCT, 0, 100 * C_CLK_PERIOD, "Wait for register check");
+
     report "Starting test";
 
     wait for 1000 ms;